@@ -0,0 +1,448 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "Baseline.h"
+
+using namespace std;
+
+Baseline::Baseline()
+{
+}
+
+Baseline::~Baseline()
+{
+}
+
+bool Baseline::load(const string &fileName)
+{
+	ifstream file(fileName);
+
+	m_jobs.clear();
+	if(!file.is_open())
+	{
+		cerr << "Unable to open baseline file " << fileName << endl;
+		return false;
+	}
+	if(read(file) == false)
+	{
+		cerr << "Invalid baseline file " << fileName << endl;
+		m_jobs.clear();
+		return false;
+	}
+
+	return true;
+}
+
+bool Baseline::save(const string &fileName) const
+{
+	const auto quote = [](const string &text)-> string
+	{
+		string quoted = "\"";
+
+		for(const auto character : text)
+		{
+			if(character == '"' || character == '\\') quoted += '\\';
+			quoted += character;
+		}
+
+		return quoted + "\"";
+	};
+	ofstream file(fileName, ios::trunc);
+
+	if(!file.is_open())
+	{
+		cerr << "Unable to create baseline file " << fileName << endl;
+		return false;
+	}
+
+	file << setprecision(15);
+	file << "{" << endl;
+	file << "\t\"version\": " << Version << "," << endl;
+	file << "\t\"jobs\": [" << endl;
+	for(size_t i = 0; i < m_jobs.size(); i++)
+	{
+		const auto &job = m_jobs[i];
+
+		file << "\t\t{" << endl;
+		file << "\t\t\t\"name\": " << quote(job.name) << "," << endl;
+		file << "\t\t\t\"metrics\": [" << endl;
+		for(size_t j = 0; j < job.metrics.size(); j++)
+		{
+			const auto &metric = job.metrics[j];
+
+			file << "\t\t\t\t{\"name\": " << quote(metric.name) << ", \"higher_is_better\": " << (metric.higherIsBetter ? "true" : "false") << ", \"samples\": [";
+			for(size_t k = 0; k < metric.samples.size(); k++) file << ((k > 0) ? ", " : "") << metric.samples[k];
+			file << "]}" << ((j + 1 < job.metrics.size()) ? "," : "") << endl;
+		}
+		file << "\t\t\t]" << endl;
+		file << "\t\t}" << ((i + 1 < m_jobs.size()) ? "," : "") << endl;
+	}
+	file << "\t]" << endl;
+	file << "}" << endl;
+
+	return file.good();
+}
+
+void Baseline::addSample(const string &jobName, const DiskBenchmark::JobSummary &summary)
+{
+	const pair<const char*, double> percentiles[] = {{"p50", 50.0}, {"p99", 99.0}, {"p99.9", 99.9}};
+
+	// Every run of a job adds one sample to each metric, latencies are in microseconds
+	getMetric(jobName, "iops", true).samples.push_back(static_cast<double>(summary.iops));
+	if(summary.totalReadOperations > 0) getMetric(jobName, "read_mb_s", true).samples.push_back(summary.readMBPerSec);
+	if(summary.totalWriteOperations > 0) getMetric(jobName, "write_mb_s", true).samples.push_back(summary.writeMBPerSec);
+	for(const auto &percentile : percentiles)
+	{
+		if(summary.readLatency.count() > 0) getMetric(jobName, string("read_") + percentile.first + "_us", false).samples.push_back(summary.readLatency.percentile(percentile.second) / 1000.0);
+		if(summary.writeLatency.count() > 0) getMetric(jobName, string("write_") + percentile.first + "_us", false).samples.push_back(summary.writeLatency.percentile(percentile.second) / 1000.0);
+	}
+}
+
+void Baseline::addSamples(const Baseline &baseline)
+{
+	for(const auto &job : baseline.m_jobs)
+	{
+		for(const auto &metric : job.metrics)
+		{
+			auto &samples = getMetric(job.name, metric.name, metric.higherIsBetter).samples;
+
+			samples.insert(samples.end(), metric.samples.begin(), metric.samples.end());
+		}
+	}
+}
+
+const Baseline::JobResultList& Baseline::getJobs() const
+{
+	return m_jobs;
+}
+
+bool Baseline::empty() const
+{
+	return m_jobs.empty();
+}
+
+Baseline::ComparisonList Baseline::compare(const Baseline &baseline, const Baseline &current, double tolerancePercentage, double latencyTolerancePercentage)
+{
+	ComparisonList comparisons;
+
+	for(const auto &currentJob : current.m_jobs)
+	{
+		for(const auto &baselineJob : baseline.m_jobs)
+		{
+			if(baselineJob.name != currentJob.name) continue;
+
+			for(const auto &currentMetric : currentJob.metrics)
+			{
+				for(const auto &baselineMetric : baselineJob.metrics)
+				{
+					if(baselineMetric.name != currentMetric.name || baselineMetric.samples.empty() || currentMetric.samples.empty()) continue;
+
+					const auto baselineSize = static_cast<double>(baselineMetric.samples.size());
+					const auto currentSize = static_cast<double>(currentMetric.samples.size());
+					const auto baselineVariance = variance(baselineMetric.samples);
+					const auto currentVariance = variance(currentMetric.samples);
+					const auto tolerance = currentMetric.higherIsBetter ? tolerancePercentage : latencyTolerancePercentage;
+					double worsening, standardError2 = 0.0, degreesOfFreedom = 0.0;
+					Comparison comparison;
+
+					comparison.jobName = currentJob.name;
+					comparison.metricName = currentMetric.name;
+					comparison.baselineMean = mean(baselineMetric.samples);
+					comparison.currentMean = mean(currentMetric.samples);
+					if(comparison.baselineMean == 0.0) continue;
+					comparison.changePercentage = (((comparison.currentMean - comparison.baselineMean) / comparison.baselineMean) * 100.0);
+					worsening = currentMetric.higherIsBetter ? (comparison.baselineMean - comparison.currentMean) : (comparison.currentMean - comparison.baselineMean);
+
+					// Welch t-test with samples on both sides, a single run is tested against the prediction interval of the other side
+					if(baselineSize >= 2 && currentSize >= 2)
+					{
+						standardError2 = ((baselineVariance / baselineSize) + (currentVariance / currentSize));
+						if(standardError2 > 0.0)
+						{
+							degreesOfFreedom = ((standardError2 * standardError2) / ((pow(baselineVariance / baselineSize, 2) / (baselineSize - 1)) + (pow(currentVariance / currentSize, 2) / (currentSize - 1))));
+						}
+					}
+					else if(baselineSize >= 2 || currentSize >= 2)
+					{
+						const auto samplesSize = max(baselineSize, currentSize);
+
+						standardError2 = (max(baselineVariance, currentVariance) * (1.0 + (1.0 / samplesSize)));
+						degreesOfFreedom = (samplesSize - 1);
+					}
+					if(baselineSize >= 2 || currentSize >= 2)
+					{
+						if(standardError2 > 0.0)
+							comparison.pValue = studentTailProbability(worsening / sqrt(standardError2), degreesOfFreedom);
+						else
+							comparison.pValue = (worsening > 0.0) ? 0.0 : 1.0;
+					}
+
+					// A regression is a worsening over the tolerance that is also statistically significant when there are enough samples
+					comparison.regression = (((worsening / comparison.baselineMean) * 100.0) > tolerance && (comparison.pValue < 0.0 || comparison.pValue < Significance));
+					comparisons.push_back(comparison);
+				}
+			}
+		}
+	}
+
+	return comparisons;
+}
+
+double Baseline::mean(const vector<double> &samples)
+{
+	double sum = 0.0;
+
+	for(const auto sample : samples) sum += sample;
+
+	return samples.empty() ? 0.0 : (sum / samples.size());
+}
+
+double Baseline::variance(const vector<double> &samples)
+{
+	const auto samplesMean = mean(samples);
+	double sum = 0.0;
+
+	if(samples.size() < 2) return 0.0;
+	for(const auto sample : samples) sum += ((sample - samplesMean) * (sample - samplesMean));
+
+	return (sum / (samples.size() - 1));
+}
+
+double Baseline::confidenceInterval(const vector<double> &samples, double confidence)
+{
+	const auto tailProbability = ((1.0 - confidence) / 2.0);
+	const auto degreesOfFreedom = static_cast<double>(samples.size() - 1);
+	double low = 0.0, high = 1000.0;
+
+	if(samples.size() < 2) return 0.0;
+
+	// Student t quantile found by bisection, the interval is mean +/- the returned half width
+	for(int i = 0; i < 100; i++)
+	{
+		const auto t = ((low + high) / 2.0);
+
+		if(studentTailProbability(t, degreesOfFreedom) > tailProbability)
+			low = t;
+		else
+			high = t;
+	}
+
+	return (((low + high) / 2.0) * sqrt(variance(samples) / samples.size()));
+}
+
+Baseline::Metric& Baseline::getMetric(const string &jobName, const string &metricName, bool higherIsBetter)
+{
+	JobResult *job = nullptr;
+
+	for(auto &jobResult : m_jobs)
+	{
+		if(jobResult.name == jobName) job = &jobResult;
+	}
+	if(job == nullptr)
+	{
+		m_jobs.push_back({jobName, {}});
+		job = &m_jobs.back();
+	}
+	for(auto &metric : job->metrics)
+	{
+		if(metric.name == metricName) return metric;
+	}
+	job->metrics.push_back({metricName, higherIsBetter, {}});
+
+	return job->metrics.back();
+}
+
+bool Baseline::read(istream &file)
+{
+	const string text((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	size_t position = 0;
+	unsigned int version = 0;
+
+	// Reader of the JSON written by save(), objects and arrays of known layout with string, number and boolean values
+	const auto skipSpaces = [&]()
+	{
+		while(position < text.size() && isspace(static_cast<unsigned char>(text[position]))) position++;
+	};
+	const auto expect = [&](char character)-> bool
+	{
+		skipSpaces();
+		if(position >= text.size() || text[position] != character) return false;
+		position++;
+		return true;
+	};
+	const auto peek = [&](char character)-> bool
+	{
+		skipSpaces();
+		return (position < text.size() && text[position] == character);
+	};
+	const auto readString = [&](string &value)-> bool
+	{
+		value.clear();
+		if(expect('"') == false) return false;
+		while(position < text.size() && text[position] != '"')
+		{
+			if(text[position] == '\\') position++;
+			if(position < text.size()) value += text[position++];
+		}
+		return expect('"');
+	};
+	const auto readNumber = [&](double &value)-> bool
+	{
+		char *end;
+
+		skipSpaces();
+		value = strtod(text.c_str() + position, &end);
+		if(end == text.c_str() + position) return false;
+		position = (end - text.c_str());
+		return true;
+	};
+	const auto readBool = [&](bool &value)-> bool
+	{
+		skipSpaces();
+		value = (text.compare(position, 4, "true") == 0);
+		if(value == false && text.compare(position, 5, "false") != 0) return false;
+		position += (value ? 4 : 5);
+		return true;
+	};
+	const auto readArray = [&](const function<bool()> &readItem)-> bool
+	{
+		if(expect('[') == false) return false;
+		if(peek(']')) return expect(']');
+		do
+		{
+			if(readItem() == false) return false;
+		}
+		while(expect(','));
+		return expect(']');
+	};
+	const auto readObject = [&](const function<bool(const string &key)> &readValue)-> bool
+	{
+		string key;
+
+		if(expect('{') == false) return false;
+		if(peek('}')) return expect('}');
+		do
+		{
+			if(readString(key) == false || expect(':') == false || readValue(key) == false) return false;
+		}
+		while(expect(','));
+		return expect('}');
+	};
+	const auto readMetric = [&](JobResult &job)-> bool
+	{
+		Metric metric;
+
+		if(readObject([&](const string &key)-> bool
+		{
+			if(key == "name") return readString(metric.name);
+			if(key == "higher_is_better") return readBool(metric.higherIsBetter);
+			if(key == "samples") return readArray([&]()-> bool
+			{
+				double sample;
+
+				if(readNumber(sample) == false) return false;
+				metric.samples.push_back(sample);
+				return true;
+			});
+			return false;
+		}) == false)
+		{
+			return false;
+		}
+		job.metrics.push_back(metric);
+
+		return true;
+	};
+	const auto readJob = [&]()-> bool
+	{
+		JobResult job;
+
+		if(readObject([&](const string &key)-> bool
+		{
+			if(key == "name") return readString(job.name);
+			if(key == "metrics") return readArray([&]() { return readMetric(job); });
+			return false;
+		}) == false)
+		{
+			return false;
+		}
+		m_jobs.push_back(job);
+
+		return true;
+	};
+
+	if(readObject([&](const string &key)-> bool
+	{
+		double value;
+
+		if(key == "version")
+		{
+			if(readNumber(value) == false) return false;
+			version = static_cast<unsigned int>(value);
+			return true;
+		}
+		if(key == "jobs") return readArray(readJob);
+		return false;
+	}) == false)
+	{
+		return false;
+	}
+
+	return (version == Version);
+}
+
+double Baseline::studentTailProbability(double t, double degreesOfFreedom)
+{
+	// Probability of a Student t value greater than t
+	const auto tail = (0.5 * incompleteBeta(degreesOfFreedom / 2.0, 0.5, degreesOfFreedom / (degreesOfFreedom + (t * t))));
+
+	return (t > 0.0) ? tail : (1.0 - tail);
+}
+
+double Baseline::incompleteBeta(double a, double b, double x)
+{
+	const auto continuedFraction = [](double a, double b, double x)-> double
+	{
+		const double epsilon = 1e-12, tiny = 1e-300;
+		double c = 1.0, d = 1.0 - (((a + b) * x) / (a + 1.0)), result;
+
+		if(fabs(d) < tiny) d = tiny;
+		d = (1.0 / d);
+		result = d;
+		for(int m = 1; m <= 200; m++)
+		{
+			const auto m2 = (2 * m);
+			auto aa = ((m * (b - m) * x) / ((a - 1 + m2) * (a + m2)));
+
+			d = (1.0 + (aa * d));
+			if(fabs(d) < tiny) d = tiny;
+			c = (1.0 + (aa / c));
+			if(fabs(c) < tiny) c = tiny;
+			d = (1.0 / d);
+			result *= (d * c);
+			aa = (-((a + m) * (a + b + m) * x) / ((a + m2) * (a + 1 + m2)));
+			d = (1.0 + (aa * d));
+			if(fabs(d) < tiny) d = tiny;
+			c = (1.0 + (aa / c));
+			if(fabs(c) < tiny) c = tiny;
+			d = (1.0 / d);
+			result *= (d * c);
+			if(fabs((d * c) - 1.0) < epsilon) break;
+		}
+
+		return result;
+	};
+	double front;
+
+	// Regularized incomplete beta function evaluated with its continued fraction (Lentz method)
+	if(x <= 0.0) return 0.0;
+	if(x >= 1.0) return 1.0;
+	front = exp(lgamma(a + b) - lgamma(a) - lgamma(b) + (a * log(x)) + (b * log(1.0 - x)));
+	if(x < ((a + 1.0) / (a + b + 2.0))) return ((front * continuedFraction(a, b, x)) / a);
+
+	return (1.0 - ((front * continuedFraction(b, a, 1.0 - x)) / b));
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <istream>
+#include <string>
+#include <vector>
+#include "DiskBenchmark.h"
+
+class Baseline
+{
+public:
+	Baseline();
+	~Baseline();
+
+	static constexpr unsigned int Version = 1;
+	static constexpr double Significance = 0.05;
+
+	struct Metric
+	{
+		std::string name;
+		bool higherIsBetter = true;
+		std::vector<double> samples;
+	};
+	using MetricList = std::vector<Metric>;
+	struct JobResult
+	{
+		std::string name;
+		MetricList metrics;
+	};
+	using JobResultList = std::vector<JobResult>;
+	struct Comparison
+	{
+		std::string jobName;
+		std::string metricName;
+		double baselineMean = 0.0;
+		double currentMean = 0.0;
+		double changePercentage = 0.0;
+		double pValue = -1.0;
+		bool regression = false;
+	};
+	using ComparisonList = std::vector<Comparison>;
+
+	bool load(const std::string &fileName);
+	bool save(const std::string &fileName) const;
+	void addSample(const std::string &jobName, const DiskBenchmark::JobSummary &summary);
+	void addSamples(const Baseline &baseline);
+	const JobResultList& getJobs() const;
+	bool empty() const;
+
+	static ComparisonList compare(const Baseline &baseline, const Baseline &current, double tolerancePercentage, double latencyTolerancePercentage);
+	static double mean(const std::vector<double> &samples);
+	static double variance(const std::vector<double> &samples);
+	static double confidenceInterval(const std::vector<double> &samples, double confidence);
+
+private:
+	JobResultList m_jobs;
+
+	Metric& getMetric(const std::string &jobName, const std::string &metricName, bool higherIsBetter);
+	bool read(std::istream &file);
+	static double studentTailProbability(double t, double degreesOfFreedom);
+	static double incompleteBeta(double a, double b, double x);
+};
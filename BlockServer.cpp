@@ -0,0 +1,171 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include "BlockFile.h"
+#include "NetFile.h"
+#include "Socket.h"
+#include "CLI11/CLI.hpp"
+
+using namespace std;
+
+static unsigned long long fileSize = 0;
+
+static bool resizeFile(const string &fileName, unsigned long long size)
+{
+	error_code error;
+
+	if(!filesystem::exists(fileName, error))
+	{
+		ofstream newFile(fileName, ios::binary);
+
+		if(!newFile.is_open()) return false;
+	}
+	if(filesystem::file_size(fileName, error) != size)
+	{
+		filesystem::resize_file(fileName, size, error);
+		if(error) return false;
+	}
+
+	return true;
+}
+
+static void serveClient(Socket client, string fileName)
+{
+	const auto peerName = client.getPeerName();
+	NetFile::Request request;
+	NetFile::Response response;
+	vector<unsigned char> buffer;
+	BlockFile file;
+	bool dataSync = false;
+
+	// An unexpected error ends only the connection of the client, not the whole server
+	try
+	{
+		// Requests are executed in order and every one gets its response, the client pipelines them to hide the latency
+		while(client.receive(&request, sizeof(request)) && request.magic == NetFile::Magic)
+		{
+			const auto operation = static_cast<NetFile::Operation>(request.operation);
+			const auto blockRequest = (operation == NetFile::Operation::Read || operation == NetFile::Operation::Write);
+			unsigned long long dataSize = 0;
+
+			response.magic = NetFile::Magic;
+			response.status = 0;
+			response.value = 0;
+			response.tag = request.tag;
+
+			// Size and offset come from the network, a block outside the file is refused before any allocation
+			if(blockRequest && (request.size == 0 || request.size > NetFile::MaxBlockSize || request.offset > fileSize || request.size > (fileSize - request.offset)))
+			{
+				response.status = 1;
+				client.send(&response, sizeof(response));
+				if(operation == NetFile::Operation::Write) break;
+				continue;
+			}
+			buffer.resize(sizeof(response) + (blockRequest ? request.size : 0));
+			if(operation == NetFile::Operation::Write && client.receive(&buffer[sizeof(response)], request.size) == false)
+			{
+				break;
+			}
+			// Every connection has its own descriptor of the file, opened with the flags of its last Open request
+			if(operation == NetFile::Operation::Open)
+			{
+				dataSync = ((request.offset & NetFile::OpenDataSync) != 0);
+				file.close();
+			}
+			if(operation != NetFile::Operation::Open && !file.isOpen() && file.open(fileName, dataSync) == false)
+			{
+				response.status = 1;
+			}
+			else switch(operation)
+			{
+				case NetFile::Operation::Open:
+					response.value = fileSize;
+					break;
+				case NetFile::Operation::Read:
+					if(file.read(request.offset, &buffer[sizeof(response)], request.size))
+					{
+						dataSize = request.size;
+						response.value = request.size;
+					}
+					else
+					{
+						response.status = 1;
+					}
+					break;
+				case NetFile::Operation::Write:
+					if(!file.write(request.offset, &buffer[sizeof(response)], request.size)) response.status = 1;
+					break;
+				case NetFile::Operation::Sync:
+				case NetFile::Operation::DataSync:
+					if(!file.sync(operation == NetFile::Operation::DataSync)) response.status = 1;
+					break;
+				default:
+					response.status = 1;
+					break;
+			}
+
+			memcpy(buffer.data(), &response, sizeof(response));
+			if(client.send(buffer.data(), sizeof(response) + dataSize) == false)
+			{
+				break;
+			}
+		}
+	}
+	catch(exception &e)
+	{
+		cerr << "Client " << peerName << " error: " << e.what() << endl;
+	}
+	cout << "Client " << peerName << " disconnected" << endl;
+}
+
+int main(int argc, char **argv)
+{
+	CLI::App app("DiskBenchmarkServer");
+	string fileName;
+	string bindAddress = "127.0.0.1";
+	int port = NetFile::DefaultPort;
+	long long megabytes = 0;
+	Socket server, client;
+	error_code error;
+
+	app.add_option("file_name", fileName, "File holding the blocks served to the net engine")->required();
+	app.add_option("-z,--file_size", megabytes, "Create or resize the file to the given size (in Mb) before serving it");
+	app.add_option("-p,--port", port, "TCP port of the server (default 7900)");
+	app.add_option("-b,--bind", bindAddress, "Address the server listens on (default 127.0.0.1, 0.0.0.0 for all the interfaces)");
+	CLI11_PARSE(app, argc, argv);
+
+	if(port <= 0 || port > 65535)
+	{
+		cerr << "Invalid port (use -h for help)" << endl;
+		return 1;
+	}
+
+	// File is sized only here, clients get its size and can't change it while other clients run their I/O
+	if(megabytes > 0 && resizeFile(fileName, static_cast<unsigned long long>(megabytes) * 1024 * 1024) == false)
+	{
+		cerr << "Unable to create file " << fileName << endl;
+		return 1;
+	}
+	fileSize = filesystem::file_size(fileName, error);
+	if(error || fileSize == 0)
+	{
+		cerr << "Missing or empty file " << fileName << " (use -z to create it)" << endl;
+		return 1;
+	}
+	if(server.listen(bindAddress, static_cast<unsigned short>(port)) == false)
+	{
+		return 1;
+	}
+
+	// Every connection is served by its own thread, the benchmark opens one connection per test thread
+	cout << "Block server listening on " << bindAddress << ":" << port << endl;
+	while(server.accept(client))
+	{
+		cout << "Client " << client.getPeerName() << " connected" << endl;
+		thread(serveClient, move(client), fileName).detach();
+	}
+
+	return 0;
+}
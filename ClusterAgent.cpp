@@ -0,0 +1,331 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <sstream>
+#include <thread>
+#include "ClusterAgent.h"
+#include "JobFile.h"
+#include "Socket.h"
+
+using namespace std;
+
+ClusterAgent::ClusterAgent() : m_logMsgFunction([](const string &logMsg){}),
+							   m_bindAddress(DefaultBindAddress),
+							   m_allowFiles(false),
+							   m_directory(".")
+{
+}
+
+ClusterAgent::~ClusterAgent()
+{
+}
+
+void ClusterAgent::setLogMsgFunction(const DiskBenchmark::LogMsgFunction &logMsgFunction)
+{
+	m_logMsgFunction = logMsgFunction;
+}
+
+void ClusterAgent::setBindAddress(const string &bindAddress)
+{
+	m_bindAddress = bindAddress;
+}
+
+void ClusterAgent::setAllowFiles(bool allowFiles)
+{
+	m_allowFiles = allowFiles;
+}
+
+void ClusterAgent::setDirectory(const string &directory)
+{
+	m_directory = directory;
+}
+
+bool ClusterAgent::run(unsigned short port)
+{
+	Socket server, controller;
+	error_code error;
+
+	if(filesystem::is_directory(m_directory, error) == false)
+	{
+		cerr << "Invalid agent directory " << m_directory << endl;
+		return false;
+	}
+	if(server.listen(m_bindAddress, port) == false)
+	{
+		return false;
+	}
+
+	// Controllers are served one at a time, every connection runs all the tests of a job file
+	cout << "Agent listening on " << m_bindAddress << ":" << port << ", test files in " << m_directory << endl;
+	while(server.accept(controller))
+	{
+		cout << "Controller " << controller.getPeerName() << " connected" << endl;
+		serveController(controller);
+		controller.close();
+		cout << "Controller disconnected" << endl;
+	}
+
+	return true;
+}
+
+void ClusterAgent::serveController(Socket &controller)
+{
+	DiskBenchmark diskBenchmark;
+	JobFile jobFile;
+	JobFile::TestList tests;
+	string message, command;
+	unsigned int heatmapMsInterval = 0;
+	size_t testIndex = 0;
+
+	if(controller.receiveMessage(message) == false)
+	{
+		return;
+	}
+
+	istringstream header(message.substr(0, message.find('\n')));
+
+	// First message is "JOB <heatmap interval>" followed by the job file text
+	header >> command >> heatmapMsInterval;
+	if(command != "JOB" || message.find('\n') == string::npos)
+	{
+		controller.sendMessage("ERROR Invalid request");
+		return;
+	}
+	if(jobFile.loadText(message.substr(message.find('\n') + 1), JobFile::Test(), DiskBenchmark::Job()) == false)
+	{
+		controller.sendMessage("ERROR Invalid job file");
+		return;
+	}
+
+	// The controller is not authenticated, writes outside the test files need the consent of whoever started the agent
+	// and the test files are created inside the agent directory
+	tests = jobFile.getTests();
+	for(auto &test : tests)
+	{
+		if(m_allowFiles == false && (test.allowDeviceWrite || !test.journalFileName.empty() || !test.traceFileName.empty()))
+		{
+			controller.sendMessage("ERROR Device writes, journal and trace files not allowed on this agent");
+			return;
+		}
+		if(test.engine != DiskBenchmark::Engine::System)
+		{
+			continue;
+		}
+		for(auto &job : test.jobs)
+		{
+			for(auto &fileName : job.fileNames)
+			{
+				if(resolveFileName(fileName, fileName) == false)
+				{
+					controller.sendMessage("ERROR File " + fileName + " outside the agent directory");
+					return;
+				}
+			}
+		}
+	}
+
+	diskBenchmark.setLogMsgFunction(m_logMsgFunction);
+	diskBenchmark.setHeatmapInterval(heatmapMsInterval);
+	for(const auto &test : tests)
+	{
+		DiskBenchmark::JobInfoList jobInfoList;
+
+		// Test waits for the start of the controller after the preparation of the files, a lost controller cancels it.
+		// The controller reads the agent clock and then sends the start time in that clock, so all the agents start together
+		diskBenchmark.setStartFunction([&]()
+		{
+			string reply, command;
+			long long nsStart = 0;
+
+			if(controller.sendMessage("READY " + to_string(testIndex)) == false)
+			{
+				diskBenchmark.stop();
+				return;
+			}
+			while(controller.receiveMessage(reply) && reply == "TIME")
+			{
+				controller.sendMessage("TIME " + to_string(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count()));
+			}
+
+			istringstream start(reply);
+
+			start >> command >> nsStart;
+			if(command != "START" || chrono::steady_clock::time_point(chrono::nanoseconds(nsStart)) > (chrono::steady_clock::now() + chrono::seconds(MaxStartSeconds)))
+			{
+				diskBenchmark.stop();
+				return;
+			}
+			this_thread::sleep_until(chrono::steady_clock::time_point(chrono::nanoseconds(nsStart)));
+		});
+		JobFile::apply(test, diskBenchmark);
+		cout << "Run test " << (test.name.empty() ? to_string(testIndex + 1) : test.name) << endl;
+		jobInfoList = diskBenchmark.executeJobs(test.jobs);
+		if(controller.sendMessage("RESULT " + to_string(testIndex) + "\n" + encodeResults(jobInfoList)) == false)
+		{
+			return;
+		}
+		testIndex++;
+	}
+	controller.sendMessage("DONE");
+}
+
+bool ClusterAgent::resolveFileName(const string &fileName, string &path) const
+{
+	const filesystem::path name(fileName);
+	error_code error;
+
+	// Absolute names and devices are accepted only with the consent of whoever started the agent, the other names
+	// are relative to the agent directory and can't leave it through '..' or a symbolic link
+	if(m_allowFiles && name.has_root_path())
+	{
+		path = fileName;
+		return true;
+	}
+	if(name.empty() || name.has_root_path() || any_of(name.begin(), name.end(), [](const filesystem::path &part) { return (part == ".."); }))
+	{
+		return false;
+	}
+
+	const auto directory = filesystem::weakly_canonical(m_directory, error);
+	const auto file = filesystem::weakly_canonical(directory / name, error);
+
+	if(error || (m_allowFiles == false && mismatch(directory.begin(), directory.end(), file.begin(), file.end()).first != directory.end()))
+	{
+		return false;
+	}
+	path = file.string();
+
+	return true;
+}
+
+string ClusterAgent::encodeResults(const DiskBenchmark::JobInfoList &jobInfoList)
+{
+	ostringstream stream;
+
+	// Strings are written with their size first since names and paths can contain spaces
+	const auto writeString = [&](const string &text)
+	{
+		stream << text.size() << " " << text << "\n";
+	};
+
+	stream << jobInfoList.size() << "\n";
+	for(const auto &jobInfo : jobInfoList)
+	{
+		writeString(jobInfo.name);
+		stream << jobInfo.blockSize << " " << jobInfo.threadInfoList.size() << "\n";
+		stream << jobInfo.steadyState.reached << " " << jobInfo.steadyState.rounds << " " << jobInfo.steadyState.averageIOPS << " "
+			   << jobInfo.steadyState.rangePercentage << " " << jobInfo.steadyState.slopePercentage << "\n";
+		for(const auto &threadInfo : jobInfo.threadInfoList)
+		{
+			stream << threadInfo.msDuration << " " << threadInfo.msRampDuration << " " << threadInfo.regionOffset << " " << threadInfo.regionSize << " "
+				   << threadInfo.totalReadOperations << " " << threadInfo.totalWriteOperations << " " << threadInfo.totalSyncOperations << " "
+				   << threadInfo.totalDiscardOperations << " " << threadInfo.totalCommits << " " << threadInfo.totalVerifiedBlocks << " "
+				   << threadInfo.totalVerifyErrors << "\n";
+			threadInfo.readLatency.save(stream);
+			threadInfo.writeLatency.save(stream);
+			threadInfo.syncLatency.save(stream);
+			threadInfo.discardLatency.save(stream);
+			threadInfo.commitLatency.save(stream);
+			threadInfo.latencyHeatmap.save(stream);
+			stream << threadInfo.targetInfoList.size() << "\n";
+			for(const auto &targetInfo : threadInfo.targetInfoList)
+			{
+				writeString(targetInfo.fileName);
+				stream << targetInfo.totalReadOperations << " " << targetInfo.totalWriteOperations << "\n";
+				targetInfo.readLatency.save(stream);
+				targetInfo.writeLatency.save(stream);
+			}
+			stream << threadInfo.verifyErrors.size() << "\n";
+			for(const auto &verifyError : threadInfo.verifyErrors)
+			{
+				writeString(verifyError.fileName);
+				stream << verifyError.offset << " " << static_cast<int>(verifyError.type) << " " << verifyError.expectedGeneration << " " << verifyError.foundGeneration << "\n";
+			}
+		}
+	}
+
+	return stream.str();
+}
+
+bool ClusterAgent::decodeResults(const string &text, DiskBenchmark::JobInfoList &jobInfoList)
+{
+	istringstream stream(text);
+	size_t jobsNumber, threadsNumber, targetsNumber, errorsNumber;
+
+	const auto readString = [&](string &value)-> bool
+	{
+		size_t size;
+
+		if(!(stream >> size) || stream.get() != ' ' || size > text.size()) return false;
+		value.resize(size);
+		return (size == 0 || stream.read(&value[0], size));
+	};
+
+	jobInfoList.clear();
+	if(!(stream >> jobsNumber))
+	{
+		return false;
+	}
+	for(size_t i = 0; i < jobsNumber; i++)
+	{
+		DiskBenchmark::JobInfo jobInfo;
+
+		if(readString(jobInfo.name) == false
+		|| !(stream >> jobInfo.blockSize >> threadsNumber)
+		|| !(stream >> jobInfo.steadyState.reached >> jobInfo.steadyState.rounds >> jobInfo.steadyState.averageIOPS >> jobInfo.steadyState.rangePercentage >> jobInfo.steadyState.slopePercentage))
+		{
+			return false;
+		}
+		for(size_t n = 0; n < threadsNumber; n++)
+		{
+			DiskBenchmark::ThreadInfo threadInfo;
+
+			if(!(stream >> threadInfo.msDuration >> threadInfo.msRampDuration >> threadInfo.regionOffset >> threadInfo.regionSize
+					    >> threadInfo.totalReadOperations >> threadInfo.totalWriteOperations >> threadInfo.totalSyncOperations
+					    >> threadInfo.totalDiscardOperations >> threadInfo.totalCommits >> threadInfo.totalVerifiedBlocks >> threadInfo.totalVerifyErrors)
+			|| threadInfo.readLatency.load(stream) == false
+			|| threadInfo.writeLatency.load(stream) == false
+			|| threadInfo.syncLatency.load(stream) == false
+			|| threadInfo.discardLatency.load(stream) == false
+			|| threadInfo.commitLatency.load(stream) == false
+			|| threadInfo.latencyHeatmap.load(stream) == false
+			|| !(stream >> targetsNumber))
+			{
+				return false;
+			}
+			for(size_t t = 0; t < targetsNumber; t++)
+			{
+				DiskBenchmark::TargetInfo targetInfo;
+
+				if(readString(targetInfo.fileName) == false
+				|| !(stream >> targetInfo.totalReadOperations >> targetInfo.totalWriteOperations)
+				|| targetInfo.readLatency.load(stream) == false
+				|| targetInfo.writeLatency.load(stream) == false)
+				{
+					return false;
+				}
+				threadInfo.targetInfoList.push_back(targetInfo);
+			}
+			if(!(stream >> errorsNumber))
+			{
+				return false;
+			}
+			for(size_t e = 0; e < errorsNumber; e++)
+			{
+				DiskBenchmark::VerifyError verifyError;
+				int type;
+
+				if(readString(verifyError.fileName) == false || !(stream >> verifyError.offset >> type >> verifyError.expectedGeneration >> verifyError.foundGeneration))
+				{
+					return false;
+				}
+				verifyError.type = static_cast<DiskBenchmark::VerifyErrorType>(type);
+				threadInfo.verifyErrors.push_back(verifyError);
+			}
+			jobInfo.threadInfoList.push_back(threadInfo);
+		}
+		jobInfoList.push_back(jobInfo);
+	}
+
+	return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include "DiskBenchmark.h"
+
+class Socket;
+
+class ClusterAgent
+{
+	static constexpr unsigned int MaxStartSeconds = 60;
+
+public:
+	ClusterAgent();
+	~ClusterAgent();
+
+	static constexpr unsigned short DefaultPort = 7810;
+	static constexpr const char *DefaultBindAddress = "127.0.0.1";
+
+	void setLogMsgFunction(const DiskBenchmark::LogMsgFunction &logMsgFunction);
+	void setBindAddress(const std::string &bindAddress);
+	void setAllowFiles(bool allowFiles);
+	void setDirectory(const std::string &directory);
+	bool run(unsigned short port);
+
+	static std::string encodeResults(const DiskBenchmark::JobInfoList &jobInfoList);
+	static bool decodeResults(const std::string &text, DiskBenchmark::JobInfoList &jobInfoList);
+
+private:
+	DiskBenchmark::LogMsgFunction m_logMsgFunction;
+	std::string m_bindAddress;
+	bool m_allowFiles;
+	std::string m_directory;
+
+	void serveController(Socket &controller);
+	bool resolveFileName(const std::string &fileName, std::string &path) const;
+};
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include "ClusterController.h"
+#include "ClusterAgent.h"
+#include "Socket.h"
+
+using namespace std;
+
+ClusterController::ClusterController()
+{
+}
+
+ClusterController::~ClusterController()
+{
+}
+
+bool ClusterController::connect(const vector<string> &agents)
+{
+	m_agents.clear();
+	m_agentNames.clear();
+	for(const auto &agent : agents)
+	{
+		const auto separator = agent.rfind(':');
+		unique_ptr<Socket> socket(new Socket());
+		unsigned long port = ClusterAgent::DefaultPort;
+
+		try
+		{
+			if(separator != string::npos) port = stoul(agent.substr(separator + 1));
+		}
+		catch(logic_error&)
+		{
+			port = 0;
+		}
+		if(port == 0 || port > 65535)
+		{
+			cerr << "Invalid agent address " << agent << endl;
+			return false;
+		}
+		if(socket->connect(agent.substr(0, separator), static_cast<unsigned short>(port)) == false)
+		{
+			return false;
+		}
+		m_agents.push_back(move(socket));
+		m_agentNames.push_back(agent);
+	}
+
+	return !m_agents.empty();
+}
+
+ClusterController::TestResultList ClusterController::run(const JobFile::TestList &tests, unsigned int heatmapMsInterval)
+{
+	const auto jobText = JobFile::toText(tests);
+	vector<bool> connected(m_agents.size(), true);
+	TestResultList testResults;
+	string message;
+
+	// Every agent receives the same tests with {agent} in the file names replaced by its number
+	for(size_t i = 0; i < m_agents.size(); i++)
+	{
+		auto agentText = jobText;
+
+		for(auto position = agentText.find("{agent}"); position != string::npos; position = agentText.find("{agent}", position))
+		{
+			agentText.replace(position, 7, to_string(i + 1));
+		}
+		if(m_agents[i]->sendMessage("JOB " + to_string(heatmapMsInterval) + "\n" + agentText) == false)
+		{
+			cerr << "Unable to send the job to agent " << m_agentNames[i] << endl;
+			connected[i] = false;
+		}
+	}
+
+	for(size_t testIndex = 0; testIndex < tests.size(); testIndex++)
+	{
+		const auto expectedReady = ("READY " + to_string(testIndex));
+		const auto expectedResult = ("RESULT " + to_string(testIndex));
+		vector<bool> ready(m_agents.size(), false);
+		TestResult testResult;
+
+		// Start is sent only when all the agents have prepared their files so the tests run at the same time
+		testResult.name = tests[testIndex].name;
+		testResult.agents.resize(m_agents.size());
+		for(size_t i = 0; i < m_agents.size(); i++)
+		{
+			testResult.agents[i].agent = m_agentNames[i];
+			if(connected[i] == false) continue;
+			if(m_agents[i]->receiveMessage(message) == false)
+			{
+				cerr << "Agent " << m_agentNames[i] << " disconnected" << endl;
+				connected[i] = false;
+			}
+			else if(message == expectedReady)
+			{
+				ready[i] = true;
+			}
+			else if(message.compare(0, expectedResult.size(), expectedResult) == 0)
+			{
+				cerr << "Agent " << m_agentNames[i] << " failed to prepare the test" << endl;
+			}
+			else
+			{
+				cerr << "Agent " << m_agentNames[i] << " error: " << message << endl;
+				connected[i] = false;
+			}
+		}
+		// Offset of every agent clock is measured with a round trip, then all the agents get the same start time in their own clock
+		const auto nsNow = []()-> long long
+		{
+			return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+		};
+		vector<long long> nsOffsets(m_agents.size(), 0);
+		long long nsMaxRoundTrip = 0, nsStart;
+
+		for(size_t i = 0; i < m_agents.size(); i++)
+		{
+			const auto nsSend = nsNow();
+			long long nsAgent = 0;
+			string command;
+
+			if(ready[i] == false) continue;
+			if(m_agents[i]->sendMessage("TIME") == false || m_agents[i]->receiveMessage(message) == false)
+			{
+				ready[i] = false;
+				continue;
+			}
+
+			const auto nsReceive = nsNow();
+			istringstream reply(message);
+
+			reply >> command >> nsAgent;
+			if(command != "TIME")
+			{
+				ready[i] = false;
+				continue;
+			}
+			nsOffsets[i] = (nsAgent - ((nsSend + nsReceive) / 2));
+			nsMaxRoundTrip = max(nsMaxRoundTrip, (nsReceive - nsSend));
+		}
+		nsStart = (nsNow() + (StartMsMargin * 1000000) + (nsMaxRoundTrip * 2));
+		for(size_t i = 0; i < m_agents.size(); i++)
+		{
+			if(ready[i] && m_agents[i]->sendMessage("START " + to_string(nsStart + nsOffsets[i])) == false) ready[i] = false;
+		}
+		for(size_t i = 0; i < m_agents.size(); i++)
+		{
+			auto &agentResult = testResult.agents[i];
+
+			if(ready[i] == false) continue;
+			if(m_agents[i]->receiveMessage(message) == false || message.compare(0, expectedResult.size(), expectedResult) != 0)
+			{
+				cerr << "Agent " << m_agentNames[i] << " disconnected" << endl;
+				connected[i] = false;
+				continue;
+			}
+			if(ClusterAgent::decodeResults(message.substr(expectedResult.size() + 1), agentResult.jobInfoList) == false)
+			{
+				cerr << "Invalid results from agent " << m_agentNames[i] << endl;
+				continue;
+			}
+			agentResult.completed = !agentResult.jobInfoList.empty();
+		}
+		testResult.jobInfoList = mergeResults(testResult.agents);
+		testResults.push_back(testResult);
+	}
+
+	return testResults;
+}
+
+DiskBenchmark::JobInfoList ClusterController::mergeResults(const AgentResultList &agents)
+{
+	DiskBenchmark::JobInfoList jobInfoList;
+
+	// Jobs with the same name on different agents become a single job with the threads of all the agents
+	for(const auto &agent : agents)
+	{
+		for(const auto &agentJobInfo : agent.jobInfoList)
+		{
+			auto jobInfo = find_if(jobInfoList.begin(), jobInfoList.end(), [&](const DiskBenchmark::JobInfo &jobInfo) { return (jobInfo.name == agentJobInfo.name); });
+
+			if(jobInfo == jobInfoList.end())
+			{
+				jobInfoList.push_back(agentJobInfo);
+			}
+			else
+			{
+				jobInfo->threadInfoList.insert(jobInfo->threadInfoList.end(), agentJobInfo.threadInfoList.begin(), agentJobInfo.threadInfoList.end());
+			}
+		}
+	}
+
+	return jobInfoList;
+}
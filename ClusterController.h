@@ -0,0 +1,42 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "DiskBenchmark.h"
+#include "JobFile.h"
+
+class Socket;
+
+class ClusterController
+{
+	static constexpr long long StartMsMargin = 100;
+
+public:
+	ClusterController();
+	~ClusterController();
+
+	struct AgentResult
+	{
+		std::string agent;
+		bool completed = false;
+		DiskBenchmark::JobInfoList jobInfoList;
+	};
+	using AgentResultList = std::vector<AgentResult>;
+	struct TestResult
+	{
+		std::string name;
+		AgentResultList agents;
+		DiskBenchmark::JobInfoList jobInfoList;
+	};
+	using TestResultList = std::vector<TestResult>;
+
+	bool connect(const std::vector<std::string> &agents);
+	TestResultList run(const JobFile::TestList &tests, unsigned int heatmapMsInterval);
+
+	static DiskBenchmark::JobInfoList mergeResults(const AgentResultList &agents);
+
+private:
+	std::vector<std::string> m_agentNames;
+	std::vector<std::unique_ptr<Socket>> m_agents;
+};
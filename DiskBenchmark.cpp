@@ -1,390 +1,2553 @@
-#include <algorithm>
-#include <chrono>
-#include <random>
-#include <thread>
-#include "DiskBenchmark.h"
-#include "SystemFile.h"
-
-using namespace std;
-
-DiskBenchmark::DiskBenchmark() : m_systemFile(new SystemFile(m_exception)),
-								 m_logMsgFunction([](const string &logMsg){}),
-								 m_unalignedOffsets(false),
-								 m_randomAccess(false),
-								 m_readPercentage(50),
-								 m_secondsDuration(0),
-								 m_crcBlock(false),
-								 m_useExistingFile(false)
-{
-}
-
-DiskBenchmark::~DiskBenchmark()
-{
-}
-
-void DiskBenchmark::setLogMsgFunction(const LogMsgFunction &logMsgFunction)
-{
-	m_systemFile->setLogMsgFunction(logMsgFunction);
-	m_logMsgFunction = logMsgFunction;
-}
-
-void DiskBenchmark::setUnalignedOffsets(bool unalignedOffsets)
-{
-	m_unalignedOffsets = unalignedOffsets;
-}
-
-void DiskBenchmark::setRandomAccess(bool randomAccess)
-{
-	m_randomAccess = randomAccess;
-}
-
-void DiskBenchmark::setReadPercentage(unsigned char readPercentage)
-{
-	if(readPercentage <= 100) m_readPercentage = readPercentage;
-}
-
-void DiskBenchmark::setWritePercentage(unsigned char writePercentage)
-{
-	if(writePercentage <= 100) m_readPercentage = (100 - writePercentage);
-}
-
-void DiskBenchmark::setSecondsDuration(unsigned int seconds)
-{
-	m_secondsDuration = seconds;
-}
-
-void DiskBenchmark::setCrcBlockCheck(bool crcBlock)
-{
-	m_crcBlock = crcBlock;
-}
-
-void DiskBenchmark::setUseExistingFile(bool useExistingFile)
-{
-	m_useExistingFile = useExistingFile;
-}
-
-DiskBenchmark::ThreadInfoList DiskBenchmark::executeTest(IOType ioType, unsigned int threadNumber, unsigned int taskNumber, const std::string &fileName, unsigned long long fileSize, unsigned long long blockSize)
-{
-	const auto offsets = calculateOffsets(fileSize, blockSize, ioType, m_readPercentage, m_randomAccess);
-	const auto pageSize = m_systemFile->getMemoryPageSize();
-	ThreadInfoList threadInfoList;
-	unsigned char *block;
-	bool result;
-
-	if(blockSize == 0 || blockSize % pageSize)
-	{
-		cerr << "Block size must be " << pageSize << " bytes aligned" << endl;
-		return threadInfoList;
-	}
-	if(threadNumber == 0 || taskNumber == 0)
-	{
-		cerr << "Invalid thread or task number" << endl;
-		return threadInfoList;
-	}
-
-	m_logMsgFunction("Initialization...");
-	block = new unsigned char[blockSize];
-	fillBlock(block, blockSize, m_crcBlock);
-	result = m_systemFile->initialize(fileName, true, fileSize, block, blockSize, m_useExistingFile);
-	delete[] block;
-
-	if(result == false)
-	{
-		cerr << "Initialization failed!" << endl;
-		return threadInfoList;
-	}
-
-	m_logMsgFunction("Start test threads");
-	try
-	{
-		if(threadNumber > 1)
-		{
-			struct ThreadData
-			{
-				future<ThreadInfo> status;
-				thread instance;
-			};
-			vector<ThreadData> threads(threadNumber);
-			unsigned int startOffsetIndex = 0;
-
-			for(auto& thread : threads)
-			{
-				promise<ThreadInfo> promise;
-				thread.status = promise.get_future();
-				thread.instance = std::thread(&DiskBenchmark::executeTasksThread, this, move(promise), taskNumber, blockSize, startOffsetIndex, ref(offsets));
-				if(m_unalignedOffsets) startOffsetIndex += (offsets.size() / threads.size());
-			}
-
-			while(!threads.empty())
-			{
-				auto thread = threads.begin();
-
-				while(thread != threads.end())
-				{
-					if(thread->status.wait_for(std::chrono::milliseconds(0)) == future_status::ready)
-					{
-						if(thread->instance.joinable()) thread->instance.join();
-						threadInfoList.push_back(thread->status.get());
-						thread = threads.erase(thread);
-					}
-					else
-					{
-						++thread;
-					}
-				}
-
-				if(m_exception) rethrow_exception(m_exception);
-			}
-		}
-		else
-		{
-			threadInfoList.push_back(executeTasks(taskNumber, blockSize, 0, offsets));
-			if(m_exception) rethrow_exception(m_exception);
-		}
-	}
-	catch(runtime_error &e)
-	{
-		cerr << "Taks error: " << e.what() << endl;
-		threadInfoList.clear();
-	}
-	
-	m_systemFile->close(!m_useExistingFile);
-
-	return threadInfoList;
-}
-
-DiskBenchmark::ThreadInfo DiskBenchmark::executeTasks(unsigned int taskNumber, unsigned long long blockSize, unsigned int startOffsetIndex, const OffsetDataList& offsets)
-{
-	struct TaskData
-	{
-		enum class State
-		{
-			Null,
-			Read,
-			Write
-		};
-		State state = State::Null;
-		SystemFile::BlockHandle block;
-		unsigned char *buffer = nullptr;
-	};
-	chrono::time_point<chrono::steady_clock> startTime;
-	SystemFile::BlockHandle *completedBlock;
-	int activeTasksCounter, offsetIndex, blocksCounter;
-	vector<TaskData> tasks(taskNumber);
-	SystemFile::FileHandle file;
-	unsigned char *buffer;
-	ThreadInfo threadInfo;
-	bool running;
-
-	m_logMsgFunction("Execute task thread started");
-	buffer = m_systemFile->allocateAlignedMemory(blockSize * taskNumber);
-	if(m_crcBlock == false) fillBlock(buffer, blockSize * taskNumber, false);
-	for(unsigned int i = 0; i < taskNumber; i++) tasks[i].buffer = &buffer[blockSize * i];
-	try
-	{
-		file = m_systemFile->openFile(taskNumber);
-
-		running = true;
-		blocksCounter = 0;
-		activeTasksCounter = 0;
-		offsetIndex = startOffsetIndex;
-		startTime = chrono::steady_clock::now();
-		do
-		{
-			if(running == true && m_secondsDuration > 0)
-			{
-				running = (chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now() - startTime).count() < m_secondsDuration) ? true : false;
-			}
-
-			if(running == true && activeTasksCounter < taskNumber)
-			{
-				for(auto &task : tasks)
-				{
-					if(task.state == TaskData::State::Null)
-					{
-						const auto offset = offsets.at(offsetIndex++);
-
-						task.state = offset.read ? TaskData::State::Read : TaskData::State::Write;
-						if(task.state == TaskData::State::Read)
-						{
-							m_systemFile->readBlock(file, offset.address, task.buffer, blockSize, &task.block);
-						}
-						else
-						{
-							if(m_crcBlock) fillBlock(task.buffer, blockSize, true);
-							m_systemFile->writeBlock(file, offset.address, task.buffer, blockSize, &task.block);
-						}
-						activeTasksCounter++;
-						if(offsetIndex >= offsets.size()) offsetIndex = 0;
-						
-						if(m_secondsDuration == 0 && ++blocksCounter >= offsets.size())
-						{
-							running = false;
-							break;
-						}
-					}
-				}
-			}
-			
-			while((completedBlock = m_systemFile->getCompletedBlock(file)) != nullptr)
-			{
-				for(auto &task : tasks)
-				{
-					if(&task.block == completedBlock)
-					{
-						if(m_crcBlock == true && task.state == TaskData::State::Read)
-						{
-							if(!checkCrcBlock(task.buffer, blockSize)) throw runtime_error("Read block crc failed");
-						}
-
-						if(task.state == TaskData::State::Read)
-							threadInfo.totalReadOperations++;
-						else
-							threadInfo.totalWriteOperations++;
-
-						task.state = TaskData::State::Null;
-						activeTasksCounter--;
-						break;
-					}
-				}
-			}
-		} while(running == true || activeTasksCounter > 0);
-		threadInfo.msDuration = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count();
-
-		m_systemFile->closeFile(file);
-	}
-	catch(...)
-	{
-		threadInfo.totalReadOperations = threadInfo.totalWriteOperations = 0;
-		m_exception = current_exception();
-	}
-	m_systemFile->freeAlignedMemory(buffer);
-	m_logMsgFunction("Execute task thread finished");
-
-	return threadInfo;
-}
-
-void DiskBenchmark::executeTasksThread(promise<ThreadInfo> promise, unsigned int taskNumber, unsigned long long blockSize, unsigned int startOffsetIndex, const OffsetDataList& offsets)
-{
-	promise.set_value(executeTasks(taskNumber, blockSize, startOffsetIndex, offsets));
-}
-
-DiskBenchmark::OffsetDataList DiskBenchmark::calculateOffsets(unsigned long long fileSize, unsigned long long blockSize, IOType ioType, unsigned char readPercentage, bool randomAccess) const
-{
-	const unsigned long long maxBlocksNumber = (fileSize / blockSize);
-	const unsigned long long maxReadBlocksNumber = ((maxBlocksNumber * readPercentage) / 100);
-	OffsetDataList offsets;
-	random_device randomDev;
-	default_random_engine randomEngine(randomDev());
-
-	for(unsigned long long i = 0; i < maxBlocksNumber; i++)
-	{
-		OffsetData offset;
-
-		offset.address = (blockSize * i);
-		switch(ioType)
-		{
-			case IOType::Read:
-				offset.read = true;
-				break;
-			case IOType::Write:
-				offset.read = false;
-				break;
-			case IOType::ReadWrite:
-				offset.read = (i < maxReadBlocksNumber) ? true : false;
-				break;
-		}
-		offsets.push_back(offset);
-	}
-	if(randomAccess)
-	{
-		shuffle(offsets.begin(), offsets.end(), randomEngine);
-	}
-
-	return offsets;
-}
-
-void DiskBenchmark::fillBlock(unsigned char *block, unsigned long long size, bool crc) const
-{
-	if(crc == true && size > 4)
-	{
-		generate_n(block, size - 4, rand);
-		*(reinterpret_cast<unsigned int*>(&block[size - 4])) = crc32(block, size - 4);
-	}
-	else
-	{
-		generate_n(block, size, rand);
-	}
-}
-
-bool DiskBenchmark::checkCrcBlock(unsigned char *block, unsigned long long size) const
-{
-	unsigned int crc1, crc2;
-
-	if(size < 4)
-	{
-		return false;
-	}
-
-	crc1 = *(reinterpret_cast<unsigned int*>(&block[size - 4]));
-	crc2 = crc32(block, size - 4);
-
-	return (crc1 == crc2) ? true : false;
-}
-
-unsigned int DiskBenchmark::crc32(unsigned char *buffer, unsigned long long size) const
-{
-	const unsigned int table[] = {
-		0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
-		0xe963a535, 0x9e6495a3,	0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
-		0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91, 0x1db71064, 0x6ab020f2,
-		0xf3b97148, 0x84be41de,	0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
-		0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec,	0x14015c4f, 0x63066cd9,
-		0xfa0f3d63, 0x8d080df5,	0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172,
-		0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b,	0x35b5a8fa, 0x42b2986c,
-		0xdbbbc9d6, 0xacbcf940,	0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
-		0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423,
-		0xcfba9599, 0xb8bda50f, 0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924,
-		0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d,	0x76dc4190, 0x01db7106,
-		0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
-		0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818, 0x7f6a0dbb, 0x086d3d2d,
-		0x91646c97, 0xe6635c01, 0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e,
-		0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457, 0x65b0d9c6, 0x12b7e950,
-		0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
-		0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2, 0x4adfa541, 0x3dd895d7,
-		0xa4d1c46d, 0xd3d6f4fb, 0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0,
-		0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cc9, 0x5005713c, 0x270241aa,
-		0xbe0b1010, 0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
-		0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17, 0x2eb40d81,
-		0xb7bd5c3b, 0xc0ba6cad, 0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a,
-		0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683, 0xe3630b12, 0x94643b84,
-		0x0d6d6a3e, 0x7a6a5aa8, 0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
-		0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb,
-		0x196c3671, 0x6e6b06e7, 0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc,
-		0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5, 0xd6d6a3e8, 0xa1d1937e,
-		0x38d8c2c4, 0x4fdff252, 0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
-		0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55,
-		0x316e8eef, 0x4669be79, 0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236,
-		0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f, 0xc5ba3bbe, 0xb2bd0b28,
-		0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
-		0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a, 0x9c0906a9, 0xeb0e363f,
-		0x72076785, 0x05005713, 0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38,
-		0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21, 0x86d3d2d4, 0xf1d4e242,
-		0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
-		0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c, 0x8f659eff, 0xf862ae69,
-		0x616bffd3, 0x166ccf45, 0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2,
-		0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db, 0xaed16a4a, 0xd9d65adc,
-		0x40df0b66, 0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
-		0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693,
-		0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
-		0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
-	};
-	unsigned int crc = 0xFFFFFFFF;
-
-	for(unsigned long long i = 0; i < size; ++i)
-	{
-		crc = (table[(crc ^ buffer[i]) & 0xFF] ^ (crc >> 8));
-	}
-
-	return (crc ^ 0xFFFFFFFF);
-}
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <thread>
+#include "DiskBenchmark.h"
+#include "SystemFile.h"
+#include "NullFile.h"
+#include "NetFile.h"
+#include "EventTrace.h"
+#include "WorkerProcess.h"
+
+using namespace std;
+
+DiskBenchmark::DiskBenchmark() : m_logMsgFunction([](const string &logMsg){}),
+								 m_progressFunction([](const string &phase, double percentage){}),
+								 m_startFunction([](){}),
+								 m_engine(Engine::System),
+								 m_crcBlock(false),
+								 m_verify(false),
+								 m_heatmapMsInterval(0),
+								 m_secondsDuration(0),
+								 m_rampSeconds(0),
+								 m_steadyStateSeconds(0),
+								 m_steadyStateWindow(5),
+								 m_steadyStateRange(20),
+								 m_steadyStateSlope(10),
+								 m_preconditionPasses(0),
+								 m_preconditionSeconds(0),
+								 m_stop(false),
+								 m_cancel(false),
+								 m_running(false),
+								 m_useExistingFile(false),
+								 m_dataSync(false),
+								 m_allowDeviceWrite(false),
+								 m_workerProcesses(false),
+								 m_networkDepth(0)
+{
+}
+
+DiskBenchmark::~DiskBenchmark()
+{
+}
+
+void DiskBenchmark::setLogMsgFunction(const LogMsgFunction &logMsgFunction)
+{
+	m_logMsgFunction = logMsgFunction;
+}
+
+void DiskBenchmark::setUnalignedOffsets(bool unalignedOffsets)
+{
+	m_defaultJob.unalignedOffsets = unalignedOffsets;
+}
+
+void DiskBenchmark::setRandomAccess(bool randomAccess)
+{
+	m_defaultJob.randomAccess = randomAccess;
+}
+
+void DiskBenchmark::setReadPercentage(unsigned char readPercentage)
+{
+	if(readPercentage <= 100) m_defaultJob.readPercentage = readPercentage;
+}
+
+void DiskBenchmark::setWritePercentage(unsigned char writePercentage)
+{
+	if(writePercentage <= 100) m_defaultJob.readPercentage = (100 - writePercentage);
+}
+
+void DiskBenchmark::setDiscardPercentage(unsigned char discardPercentage)
+{
+	if(discardPercentage <= 100) m_defaultJob.discardPercentage = discardPercentage;
+}
+
+void DiskBenchmark::setCompressionRatio(double compressionRatio)
+{
+	if(compressionRatio >= 1.0) m_defaultJob.compressionRatio = compressionRatio;
+}
+
+void DiskBenchmark::setDedupePercentage(unsigned char dedupePercentage)
+{
+	if(dedupePercentage <= 100) m_defaultJob.dedupePercentage = dedupePercentage;
+}
+
+void DiskBenchmark::setSecondsDuration(unsigned int seconds)
+{
+	m_secondsDuration = seconds;
+}
+
+void DiskBenchmark::setRampSeconds(unsigned int seconds)
+{
+	m_rampSeconds = seconds;
+}
+
+void DiskBenchmark::setSteadyState(unsigned int secondsRound)
+{
+	m_steadyStateSeconds = secondsRound;
+}
+
+void DiskBenchmark::setSteadyStateWindow(unsigned int rounds)
+{
+	m_steadyStateWindow = rounds;
+}
+
+void DiskBenchmark::setSteadyStateRange(unsigned int percentage)
+{
+	m_steadyStateRange = percentage;
+}
+
+void DiskBenchmark::setSteadyStateSlope(unsigned int percentage)
+{
+	m_steadyStateSlope = percentage;
+}
+
+void DiskBenchmark::setPrecondition(unsigned int fillPasses, unsigned int randomSeconds)
+{
+	m_preconditionPasses = fillPasses;
+	m_preconditionSeconds = randomSeconds;
+}
+
+void DiskBenchmark::setProgressFunction(const ProgressFunction &progressFunction)
+{
+	m_progressFunction = progressFunction;
+}
+
+void DiskBenchmark::setStartFunction(const StartFunction &startFunction)
+{
+	m_startFunction = startFunction;
+}
+
+void DiskBenchmark::setCrcBlockCheck(bool crcBlock)
+{
+	m_crcBlock = crcBlock;
+}
+
+void DiskBenchmark::setVerify(bool verify)
+{
+	m_verify = verify;
+}
+
+void DiskBenchmark::setJournal(const string &fileName)
+{
+	m_journalFileName = fileName;
+}
+
+void DiskBenchmark::setTrace(const string &fileName)
+{
+	m_traceFileName = fileName;
+}
+
+void DiskBenchmark::setHeatmapInterval(unsigned int milliseconds)
+{
+	m_heatmapMsInterval = milliseconds;
+}
+
+void DiskBenchmark::setUseExistingFile(bool useExistingFile)
+{
+	m_useExistingFile = useExistingFile;
+}
+
+void DiskBenchmark::setEngine(Engine engine)
+{
+	m_engine = engine;
+}
+
+void DiskBenchmark::setSyncType(SyncType syncType)
+{
+	m_defaultJob.syncType = syncType;
+}
+
+void DiskBenchmark::setSyncWritesInterval(unsigned int writes)
+{
+	m_defaultJob.syncWritesInterval = writes;
+}
+
+void DiskBenchmark::setSyncMsInterval(unsigned int milliseconds)
+{
+	m_defaultJob.syncMsInterval = milliseconds;
+}
+
+void DiskBenchmark::setDataSync(bool dataSync)
+{
+	m_dataSync = dataSync;
+}
+
+void DiskBenchmark::setGroupCommit(unsigned int records)
+{
+	if(records > 0) m_defaultJob.groupCommit = records;
+}
+
+void DiskBenchmark::setAllowDeviceWrite(bool allowDeviceWrite)
+{
+	m_allowDeviceWrite = allowDeviceWrite;
+}
+
+void DiskBenchmark::setTargetMode(TargetMode targetMode)
+{
+	m_defaultJob.targetMode = targetMode;
+}
+
+void DiskBenchmark::setStripeSize(unsigned long long stripeSize)
+{
+	m_defaultJob.stripeSize = stripeSize;
+}
+
+void DiskBenchmark::setQueueMode(QueueMode queueMode)
+{
+	m_defaultJob.queueMode = queueMode;
+}
+
+void DiskBenchmark::setRegions(const RegionList &regions)
+{
+	m_defaultJob.regions = regions;
+}
+
+void DiskBenchmark::setWorkerProcesses(bool workerProcesses)
+{
+	m_workerProcesses = workerProcesses;
+}
+
+void DiskBenchmark::setNetworkDepth(unsigned int depth)
+{
+	m_networkDepth = depth;
+}
+
+void DiskBenchmark::setRateLimit(unsigned int iops)
+{
+	m_defaultJob.rateLimit = iops;
+}
+
+DiskBenchmark::ThreadInfoList DiskBenchmark::executeTest(IOType ioType, unsigned int threadNumber, unsigned int taskNumber, const std::string &fileName, unsigned long long fileSize, unsigned long long blockSize)
+{
+	auto job = m_defaultJob;
+	JobInfoList jobInfoList;
+
+	job.ioType = ioType;
+	job.threadNumber = threadNumber;
+	job.taskNumber = taskNumber;
+	job.fileNames = {fileName};
+	job.fileSize = fileSize;
+	job.blockSize = blockSize;
+	jobInfoList = executeJobs({job});
+
+	return jobInfoList.empty() ? ThreadInfoList() : move(jobInfoList.front().threadInfoList);
+}
+
+DiskBenchmark::JobInfoList DiskBenchmark::executeJobs(JobList jobs)
+{
+	JobInfoList jobInfoList;
+
+	if(beginJobs() == false)
+	{
+		return jobInfoList;
+	}
+	jobInfoList = runJobs(move(jobs));
+	m_running = false;
+
+	return jobInfoList;
+}
+
+future<DiskBenchmark::JobInfoList> DiskBenchmark::startJobs(JobList jobs)
+{
+	// Test runs in its own thread, the caller can poll the future and the progress or stop the test at any time
+	if(beginJobs() == false)
+	{
+		promise<JobInfoList> emptyResult;
+
+		emptyResult.set_value(JobInfoList());
+		return emptyResult.get_future();
+	}
+
+	return async(launch::async, [this](JobList jobs)
+	{
+		auto jobInfoList = runJobs(move(jobs));
+
+		m_running = false;
+		return jobInfoList;
+	}, move(jobs));
+}
+
+DiskBenchmark::ProgressInfo DiskBenchmark::getProgress() const
+{
+	lock_guard<mutex> lock(m_progressMutex);
+	ProgressInfo progressInfo;
+
+	progressInfo.running = m_running;
+	progressInfo.phase = m_phase;
+	progressInfo.msPhaseDuration = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - m_phaseStartTime).count();
+	for(size_t i = 0; i < m_progress.size(); i++)
+	{
+		JobProgress jobProgress;
+
+		jobProgress.name = m_progressJobNames[i];
+		jobProgress.activeThreads = static_cast<unsigned int>(m_progress[i].size());
+		for(const auto &threadProgress : m_progress[i])
+		{
+			jobProgress.readOperations += threadProgress.readOperations.load(memory_order_relaxed);
+			jobProgress.writeOperations += threadProgress.writeOperations.load(memory_order_relaxed);
+			jobProgress.discardOperations += threadProgress.discardOperations.load(memory_order_relaxed);
+		}
+		progressInfo.jobs.push_back(jobProgress);
+	}
+
+	return progressInfo;
+}
+
+bool DiskBenchmark::isRunning() const
+{
+	return m_running;
+}
+
+bool DiskBenchmark::beginJobs()
+{
+	if(m_running.exchange(true))
+	{
+		cerr << "A test is already running" << endl;
+		return false;
+	}
+	m_cancel = false;
+
+	return true;
+}
+
+void DiskBenchmark::setPhase(const string &phase)
+{
+	lock_guard<mutex> lock(m_progressMutex);
+
+	m_phase = phase;
+	m_phaseStartTime = chrono::steady_clock::now();
+}
+
+DiskBenchmark::ThreadProgress* DiskBenchmark::addThreadProgress(size_t jobIndex)
+{
+	lock_guard<mutex> lock(m_progressMutex);
+
+	m_progress[jobIndex].emplace_back();
+
+	return &m_progress[jobIndex].back();
+}
+
+DiskBenchmark::JobInfoList DiskBenchmark::runJobs(JobList jobs)
+{
+	struct FileData
+	{
+		std::unique_ptr<SystemFile> systemFile;
+		const Job *initJob = nullptr;
+	};
+	struct ThreadData
+	{
+		size_t jobIndex = 0;
+		future<ThreadInfo> status;
+		thread instance;
+	};
+	struct ProcessThreadData
+	{
+		size_t threadIndex = 0;
+		promise<ThreadInfo> status;
+		WorkerProcess *workerProcess = nullptr;
+		ProcessResult *result = nullptr;
+		TargetList targets;
+		ThreadProgress *progress = nullptr;
+	};
+	struct SteadyStateData
+	{
+		vector<double> samples;
+		unsigned long long lastOperations = 0;
+	};
+	map<string, FileData> files;
+	map<string, VerifyData> verifyData;
+	vector<OffsetDataList> offsets(jobs.size());
+	unique_ptr<atomic<unsigned long long>[]> queueCursors(new atomic<unsigned long long>[jobs.size()]());
+	vector<OffsetQueueList> regionQueues(jobs.size());
+	vector<SteadyStateData> steadyStates(jobs.size());
+	chrono::time_point<chrono::steady_clock> roundTime;
+	vector<unique_ptr<WorkerProcess>> workerProcesses;
+	vector<ProcessThreadData> processThreads;
+	vector<ThreadData> threads;
+	unique_ptr<SystemFile> journalFile;
+	JournalTargetList journalTargets;
+	atomic<bool> journalStop(false);
+	thread journalThread;
+	JobInfoList jobInfoList;
+
+	// Error of a previous run must not end this one
+	m_exception = nullptr;
+	setPhase("Prepare");
+	{
+		lock_guard<mutex> lock(m_progressMutex);
+
+		m_progress.clear();
+		m_progress.resize(jobs.size());
+		m_progressJobNames.clear();
+		for(const auto &job : jobs) m_progressJobNames.push_back(job.name);
+	}
+	if(jobs.empty())
+	{
+		cerr << "No job to execute" << endl;
+		return jobInfoList;
+	}
+	if(m_steadyStateSeconds > 0 && m_steadyStateWindow < 2)
+	{
+		cerr << "Steady state window must be at least two rounds" << endl;
+		return jobInfoList;
+	}
+	if(!m_journalFileName.empty() && m_verify == false)
+	{
+		cerr << "Journal requires verify" << endl;
+		return jobInfoList;
+	}
+	if(m_workerProcesses && (m_verify || !m_traceFileName.empty() || m_heatmapMsInterval > 0
+	|| any_of(jobs.begin(), jobs.end(), [](const Job &job) { return (job.queueMode == QueueMode::Shared); })))
+	{
+		// Block generations, trace rings, heatmaps and the shared queue cursor live in the memory of the main process
+		cerr << "Worker processes can't be used with verify, journal, trace, heatmap or shared queue" << endl;
+		return jobInfoList;
+	}
+
+	const auto closeFiles = [&]()
+	{
+		// Files listed in a journal are kept for the check after the restart
+		for(auto &file : files) file.second.systemFile->close(!m_useExistingFile && m_journalFileName.empty());
+	};
+	const auto stopJournal = [&]()
+	{
+		journalStop = true;
+		if(journalThread.joinable()) journalThread.join();
+	};
+	const auto closeTrace = [&]()
+	{
+		if(m_eventTrace)
+		{
+			m_eventTrace->close();
+			if(m_eventTrace->getDroppedEvents() > 0) cerr << m_eventTrace->getDroppedEvents() << " trace events dropped" << endl;
+			m_eventTrace.reset();
+		}
+	};
+
+	for(const auto &job : jobs)
+	{
+		if(job.fileNames.empty())
+		{
+			cerr << "Missing file name" << endl;
+			return jobInfoList;
+		}
+		if(job.blockSize == 0)
+		{
+			cerr << "Invalid block size" << endl;
+			return jobInfoList;
+		}
+		if(job.threadNumber == 0 || job.taskNumber == 0)
+		{
+			cerr << "Invalid thread or task number" << endl;
+			return jobInfoList;
+		}
+
+		if(job.discardPercentage > 0 && (job.ioType == IOType::Write || job.ioType == IOType::ReadWrite))
+		{
+			if(m_crcBlock)
+			{
+				cerr << "Discarded blocks can't pass the crc check" << endl;
+				return jobInfoList;
+			}
+			if(job.ioType == IOType::ReadWrite && (job.readPercentage + job.discardPercentage) > 100)
+			{
+				cerr << "Read and discard percentages exceed 100" << endl;
+				return jobInfoList;
+			}
+		}
+		if(m_verify && (m_crcBlock || job.discardPercentage > 0))
+		{
+			cerr << "Verify can't be used with crc check or discard" << endl;
+			return jobInfoList;
+		}
+		if(m_crcBlock && (job.compressionRatio > 1.0 || job.dedupePercentage > 0))
+		{
+			cerr << "Compressible or dedupable data can't be used with the crc check" << endl;
+			return jobInfoList;
+		}
+		if(job.ioType == IOType::Append && job.fileNames.size() > 1)
+		{
+			cerr << "Append test supports a single file" << endl;
+			return jobInfoList;
+		}
+
+		for(const auto &fileName : job.fileNames)
+		{
+			auto &file = files[fileName];
+
+			if(!file.systemFile) file.systemFile = createSystemFile();
+
+			// Jobs sharing the same file need it big enough for all of them
+			if(file.initJob == nullptr || job.fileSize > file.initJob->fileSize) file.initJob = &job;
+		}
+	}
+
+	m_logMsgFunction("Initialization...");
+	for(auto &file : files)
+	{
+		const auto &initJob = *file.second.initJob;
+		unsigned char *block;
+		bool result;
+
+		block = new unsigned char[initJob.blockSize];
+		if(m_crcBlock)
+			fillBlock(block, initJob.blockSize, true);
+		else
+			fillTaskBuffers(block, 1, initJob);
+		// With a journal the writes must be durable when acknowledged, or lost writes would be reported after a crash
+		result = file.second.systemFile->initialize(file.first, true, m_dataSync || !m_journalFileName.empty(), initJob.fileSize, block, initJob.blockSize, m_useExistingFile);
+		delete[] block;
+
+		if(result == false)
+		{
+			cerr << "Initialization failed!" << endl;
+			closeFiles();
+			return jobInfoList;
+		}
+	}
+
+	for(auto &job : jobs)
+	{
+		for(const auto &fileName : job.fileNames)
+		{
+			const auto systemFile = files[fileName].systemFile.get();
+			const auto blockAlignment = systemFile->getBlockAlignment();
+
+			// Size of block devices is known only after initialization, a job without size use all the device
+			// and with several files the smallest one limit the size used on each of them
+			if(job.fileSize == 0 || job.fileSize > systemFile->getFileSize()) job.fileSize = systemFile->getFileSize();
+
+			if(job.blockSize % blockAlignment)
+			{
+				cerr << "Block size must be " << blockAlignment << " bytes aligned" << endl;
+				closeFiles();
+				return jobInfoList;
+			}
+			if(systemFile->isBlockDevice())
+			{
+				if(job.ioType != IOType::Read && m_allowDeviceWrite == false)
+				{
+					cerr << "Write test on block device " << fileName << " destroys its content and must be explicitly allowed" << endl;
+					closeFiles();
+					return jobInfoList;
+				}
+				if(job.ioType == IOType::Append && job.fileSize >= systemFile->getFileSize())
+				{
+					cerr << "Append test on block device " << fileName << " requires a size smaller than the device" << endl;
+					closeFiles();
+					return jobInfoList;
+				}
+			}
+		}
+
+		if(job.fileSize < job.blockSize)
+		{
+			cerr << "File size must be at least one block" << endl;
+			closeFiles();
+			return jobInfoList;
+		}
+		if(job.targetMode == TargetMode::Stripe && (job.stripeSize < job.blockSize || job.stripeSize % job.blockSize || job.fileSize < job.stripeSize))
+		{
+			cerr << "Stripe size must be a multiple of block size not bigger than the file size" << endl;
+			closeFiles();
+			return jobInfoList;
+		}
+		if(job.queueMode != QueueMode::Thread && job.targetMode == TargetMode::Thread)
+		{
+			cerr << "Shared or partitioned offsets can't be used with one file per thread" << endl;
+			closeFiles();
+			return jobInfoList;
+		}
+		if((job.queueMode == QueueMode::Partition || job.queueMode == QueueMode::Region) && (job.fileSize / job.blockSize) < job.threadNumber)
+		{
+			cerr << "Partitioned offsets require at least one block per thread" << endl;
+			closeFiles();
+			return jobInfoList;
+		}
+		if(job.queueMode == QueueMode::Region && (job.ioType == IOType::Append || job.fileNames.size() > 1))
+		{
+			cerr << "Regions require a single file and can't be used with append test" << endl;
+			closeFiles();
+			return jobInfoList;
+		}
+		if(job.queueMode == QueueMode::Region && !job.regions.empty())
+		{
+			if(job.regions.size() != job.threadNumber)
+			{
+				cerr << "Number of regions must match the number of threads" << endl;
+				closeFiles();
+				return jobInfoList;
+			}
+			for(const auto &region : job.regions)
+			{
+				if(region.offset % job.blockSize || region.size < job.blockSize || (region.offset + region.size) > job.fileSize)
+				{
+					cerr << "Regions must start at a multiple of block size and be inside the file" << endl;
+					closeFiles();
+					return jobInfoList;
+				}
+			}
+		}
+	}
+
+	// Expected generation of every block is kept while writing, reads are checked against it
+	for(auto &job : jobs)
+	{
+		for(const auto &fileName : job.fileNames)
+		{
+			if(m_verify == false || job.ioType == IOType::Append)
+			{
+				continue;
+			}
+
+			auto &data = verifyData[fileName];
+
+			if(data.blockSize == 0)
+			{
+				const auto blocksNumber = (files[fileName].systemFile->getFileSize() / job.blockSize);
+
+				data.fileId = static_cast<unsigned int>(verifyData.size());
+				data.fileSize = files[fileName].systemFile->getFileSize();
+				data.blockSize = job.blockSize;
+				data.blocksNumber = blocksNumber;
+				data.issuedGenerations.reset(new atomic<unsigned int>[blocksNumber]());
+				data.completedGenerations.reset(new atomic<unsigned int>[blocksNumber]());
+				data.pendingWrites.reset(new atomic<unsigned int>[blocksNumber]());
+			}
+			else if(data.blockSize != job.blockSize)
+			{
+				cerr << "Verify requires the same block size for all the jobs using " << fileName << endl;
+				closeFiles();
+				return jobInfoList;
+			}
+		}
+	}
+
+	if(!m_journalFileName.empty())
+	{
+		journalFile = createJournal(verifyData, journalTargets);
+		if(!journalFile)
+		{
+			closeFiles();
+			return jobInfoList;
+		}
+	}
+
+	if(m_preconditionPasses > 0 || m_preconditionSeconds > 0)
+	{
+		TargetList targets;
+		vector<const Job*> targetJobs;
+
+		for(const auto &file : files)
+		{
+			Target target;
+
+			if(file.second.systemFile->isBlockDevice() && m_allowDeviceWrite == false)
+			{
+				cerr << "Precondition of block device " << file.first << " destroys its content and must be explicitly allowed" << endl;
+				closeFiles();
+				return jobInfoList;
+			}
+			target.fileName = file.first;
+			target.systemFile = file.second.systemFile.get();
+			targets.push_back(target);
+			targetJobs.push_back(file.second.initJob);
+		}
+
+		setPhase("Precondition");
+		if(preconditionFiles(targets, targetJobs) == false)
+		{
+			cerr << "Precondition failed!" << endl;
+			closeFiles();
+			return jobInfoList;
+		}
+		if(m_cancel)
+		{
+			m_logMsgFunction("Test cancelled during precondition");
+			closeFiles();
+			return jobInfoList;
+		}
+	}
+
+	for(size_t i = 0; i < jobs.size(); i++)
+	{
+		JobInfo jobInfo;
+
+		const auto &job = jobs[i];
+		const auto targetsNumber = static_cast<unsigned int>(job.fileNames.size());
+
+		// Append job use the first thread as log writer while the others read randomly the initial file content
+		if(job.ioType == IOType::Append)
+		{
+			offsets[i] = calculateOffsets(job.fileSize, job.blockSize, IOType::Read, 100, 0, true);
+		}
+		else if(job.queueMode == QueueMode::Region)
+		{
+			// Offsets of the regions follow each other in the list, every thread walks only the part of its region
+			for(const auto &region : calculateRegions(job))
+			{
+				auto regionOffsets = calculateOffsets(region.size, job.blockSize, job.ioType, job.readPercentage, job.discardPercentage, job.randomAccess);
+				OffsetQueue queue;
+
+				for(auto &offset : regionOffsets) offset.address += region.offset;
+				queue.startIndex = offsets[i].size();
+				queue.size = regionOffsets.size();
+				queue.regionOffset = region.offset;
+				queue.regionSize = region.size;
+				offsets[i].insert(offsets[i].end(), regionOffsets.begin(), regionOffsets.end());
+				regionQueues[i].push_back(queue);
+			}
+		}
+		else if(job.targetMode == TargetMode::Thread || targetsNumber == 1)
+		{
+			offsets[i] = calculateOffsets(job.fileSize, job.blockSize, job.ioType, job.readPercentage, job.discardPercentage, job.randomAccess);
+		}
+		else
+		{
+			// Offsets cover all the files as a single space split in stripes, round robin is a stripe of one block
+			const auto stripeSize = (job.targetMode == TargetMode::Stripe) ? job.stripeSize : job.blockSize;
+
+			offsets[i] = calculateOffsets((job.fileSize / stripeSize) * stripeSize * targetsNumber, job.blockSize, job.ioType, job.readPercentage, job.discardPercentage, job.randomAccess);
+			stripeOffsets(offsets[i], targetsNumber, stripeSize);
+		}
+
+		jobInfo.name = jobs[i].name;
+		jobInfo.blockSize = jobs[i].blockSize;
+		jobInfoList.push_back(jobInfo);
+	}
+
+	const auto jobTargets = [&](size_t jobIndex)-> TargetList
+	{
+		TargetList targets;
+
+		for(const auto &fileName : jobs[jobIndex].fileNames)
+		{
+			Target target;
+
+			target.fileName = fileName;
+			target.systemFile = files[fileName].systemFile.get();
+			if(verifyData.count(fileName) > 0) target.verifyData = &verifyData[fileName];
+			targets.push_back(target);
+		}
+
+		return targets;
+	};
+
+	// Steady state is checked by the main thread while the test threads are running
+	const auto updateSteadyState = [&]()
+	{
+		bool reached = true;
+
+		for(size_t i = 0; i < jobs.size(); i++)
+		{
+			auto &steadyState = steadyStates[i];
+			auto &steadyStateInfo = jobInfoList[i].steadyState;
+			unsigned long long operations = 0;
+
+			for(const auto &threadProgress : m_progress[i]) operations += threadProgress.operations.load(memory_order_relaxed);
+
+			// Counters restart when a thread end its ramp time
+			if(operations < steadyState.lastOperations)
+				steadyState.samples.clear();
+			else
+				steadyState.samples.push_back(static_cast<double>(operations - steadyState.lastOperations) / m_steadyStateSeconds);
+			if(steadyState.samples.size() > m_steadyStateWindow) steadyState.samples.erase(steadyState.samples.begin());
+			steadyState.lastOperations = operations;
+
+			steadyStateInfo.rounds++;
+			if(steadyState.samples.size() > 1) checkSteadyState(steadyState.samples, steadyStateInfo);
+			if(steadyState.samples.size() < m_steadyStateWindow) steadyStateInfo.reached = false;
+			if(steadyStateInfo.reached == false) reached = false;
+		}
+
+		if(reached)
+		{
+			m_logMsgFunction("Steady state reached");
+			m_stop = true;
+		}
+	};
+
+	if(!m_traceFileName.empty())
+	{
+		m_eventTrace.reset(new EventTrace());
+		if(m_eventTrace->open(m_traceFileName) == false)
+		{
+			m_eventTrace.reset();
+			closeFiles();
+			return jobInfoList;
+		}
+	}
+
+	// Files are ready, the caller can hold the start to synchronize the test with other benchmarks
+	m_startFunction();
+	m_stop = m_cancel.load();
+	setPhase("Test");
+	m_logMsgFunction("Start test threads");
+	try
+	{
+		if(journalFile) journalThread = std::thread(&DiskBenchmark::executeJournal, this, journalFile.get(), cref(journalTargets), &journalStop);
+		if(jobs.size() > 1 || jobs.front().threadNumber > 1 || m_steadyStateSeconds > 0 || m_workerProcesses)
+		{
+			for(size_t i = 0; i < jobs.size(); i++)
+			{
+				const auto &job = jobs[i];
+				const auto targets = jobTargets(i);
+				const auto appendAddress = ((job.fileSize / job.blockSize) * job.blockSize);
+				const auto queueThreads = (job.ioType == IOType::Append) ? (job.threadNumber - 1) : job.threadNumber;
+				unsigned int queueThreadIndex = 0;
+				size_t startOffsetIndex = 0;
+
+				for(unsigned int n = 0; n < job.threadNumber; n++)
+				{
+					promise<ThreadInfo> promise;
+					ThreadData thread;
+
+					thread.jobIndex = i;
+					thread.status = promise.get_future();
+					const auto threadProgress = addThreadProgress(i);
+
+					// Worker processes are all forked by this thread before any test thread exists, the threads
+					// following them are started once every process is running
+					const auto startProcess = [&](const WorkerTask &task, const TargetList &processTargets)
+					{
+						ProcessThreadData processThread;
+
+						workerProcesses.emplace_back(new WorkerProcess());
+						processThread.threadIndex = threads.size();
+						processThread.status = move(promise);
+						processThread.workerProcess = workerProcesses.back().get();
+						processThread.result = startWorkerProcess(*processThread.workerProcess, task, processTargets.size());
+						processThread.targets = processTargets;
+						processThread.progress = threadProgress;
+						processThreads.push_back(move(processThread));
+					};
+
+					if(job.ioType == IOType::Append && n == 0)
+					{
+						const auto systemFile = targets.front().systemFile;
+						const auto recordsNumber = offsets[i].size();
+
+						if(m_workerProcesses)
+							startProcess([this, systemFile, &job, appendAddress, recordsNumber](ThreadProgress *progress) { return executeAppendTasks(systemFile, job, appendAddress, recordsNumber, progress); }, TargetList{targets.front()});
+						else
+							thread.instance = std::thread(&DiskBenchmark::executeAppendTasksThread, this, move(promise), systemFile, cref(job), appendAddress, recordsNumber, threadProgress);
+					}
+					else
+					{
+						const auto threadTargets = (job.targetMode == TargetMode::Thread) ? TargetList{targets[n % targets.size()]} : targets;
+						OffsetQueue queue;
+
+						// Shared and partitioned queues give every offset to a single thread for each pass over the list
+						queue.startIndex = startOffsetIndex;
+						queue.size = offsets[i].size();
+						if(job.queueMode == QueueMode::Shared)
+						{
+							queue.startIndex = 0;
+							queue.sharedCursor = &queueCursors[i];
+						}
+						else if(job.queueMode == QueueMode::Partition)
+						{
+							queue.startIndex = ((offsets[i].size() * queueThreadIndex) / queueThreads);
+							queue.size = (((offsets[i].size() * (queueThreadIndex + 1)) / queueThreads) - queue.startIndex);
+						}
+						else if(job.queueMode == QueueMode::Region)
+						{
+							queue = regionQueues[i][queueThreadIndex];
+						}
+						queueThreadIndex++;
+
+						if(m_workerProcesses)
+						{
+							const auto &jobOffsets = offsets[i];
+
+							startProcess([this, threadTargets, &job, queue, &jobOffsets](ThreadProgress *progress) { return executeTasks(threadTargets, job, queue, jobOffsets, progress); }, threadTargets);
+						}
+						else
+						{
+							thread.instance = std::thread(&DiskBenchmark::executeTasksThread, this, move(promise), threadTargets, cref(job), queue, cref(offsets[i]), threadProgress);
+						}
+						if(job.unalignedOffsets) startOffsetIndex += (offsets[i].size() / job.threadNumber);
+					}
+					threads.push_back(move(thread));
+				}
+			}
+			for(auto &processThread : processThreads)
+			{
+				threads[processThread.threadIndex].instance = std::thread(&DiskBenchmark::executeProcessThread, this, move(processThread.status), processThread.workerProcess, processThread.result, processThread.targets, processThread.progress);
+			}
+			processThreads.clear();
+
+			roundTime = (chrono::steady_clock::now() + chrono::seconds(m_rampSeconds + m_steadyStateSeconds));
+			while(!threads.empty())
+			{
+				auto thread = threads.begin();
+
+				if(m_steadyStateSeconds > 0 && m_stop == false && chrono::steady_clock::now() >= roundTime)
+				{
+					roundTime += chrono::seconds(m_steadyStateSeconds);
+					updateSteadyState();
+				}
+
+				while(thread != threads.end())
+				{
+					if(thread->status.wait_for(std::chrono::milliseconds(0)) == future_status::ready)
+					{
+						if(thread->instance.joinable()) thread->instance.join();
+						jobInfoList[thread->jobIndex].threadInfoList.push_back(thread->status.get());
+						thread = threads.erase(thread);
+					}
+					else
+					{
+						++thread;
+					}
+				}
+
+				if(m_exception) rethrow_exception(m_exception);
+				if(!threads.empty()) this_thread::sleep_for(chrono::milliseconds(1));
+			}
+		}
+		else
+		{
+			const auto &job = jobs.front();
+			const auto targets = jobTargets(0);
+			const auto threadProgress = addThreadProgress(0);
+
+			if(job.ioType == IOType::Append)
+				jobInfoList.front().threadInfoList.push_back(executeAppendTasks(targets.front().systemFile, job, ((job.fileSize / job.blockSize) * job.blockSize), offsets.front().size(), threadProgress));
+			else
+				jobInfoList.front().threadInfoList.push_back(executeTasks((job.targetMode == TargetMode::Thread) ? TargetList{targets.front()} : targets, job, regionQueues.front().empty() ? OffsetQueue{0, offsets.front().size()} : regionQueues.front().front(), offsets.front(), threadProgress));
+			if(m_exception) rethrow_exception(m_exception);
+		}
+		stopJournal();
+		closeTrace();
+		if(m_exception) rethrow_exception(m_exception);
+
+		// Every block written during the test is read back once at the end
+		if(!verifyData.empty()) setPhase("Verify");
+		for(auto &data : verifyData)
+		{
+			Target target;
+
+			target.fileName = data.first;
+			target.systemFile = files[data.first].systemFile.get();
+			target.verifyData = &data.second;
+			jobInfoList.push_back(verifyFile(target, *files[data.first].initJob));
+			if(m_exception) rethrow_exception(m_exception);
+		}
+	}
+	catch(runtime_error &e)
+	{
+		cerr << "Taks error: " << e.what() << endl;
+		jobInfoList.clear();
+	}
+	
+	stopJournal();
+	closeTrace();
+	if(journalFile) journalFile->close(false);
+	closeFiles();
+	setPhase("");
+
+	return jobInfoList;
+}
+
+DiskBenchmark::JobInfoList DiskBenchmark::checkJournal(unsigned int taskNumber)
+{
+	map<string, unique_ptr<SystemFile>> files;
+	map<string, VerifyData> verifyData;
+	ifstream journal(m_journalFileName, ios::binary);
+	JournalHeader header;
+	JobInfoList jobInfoList;
+
+	const auto closeFiles = [&]()
+	{
+		for(auto &file : files) file.second->close(false);
+	};
+
+	m_cancel = false;
+	m_exception = nullptr;
+	if(!journal.is_open())
+	{
+		cerr << "Unable to open journal file " << m_journalFileName << endl;
+		return jobInfoList;
+	}
+	if(!journal.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != JournalMagic)
+	{
+		cerr << "Invalid journal file " << m_journalFileName << endl;
+		return jobInfoList;
+	}
+
+	// Files are opened as they were left by the test, expected generations are the last acknowledged ones saved in the journal
+	for(unsigned int i = 0; i < header.filesNumber; i++)
+	{
+		JournalFileEntry entry;
+		error_code errorCode;
+		vector<unsigned int> generations;
+
+		journal.seekg(sizeof(JournalHeader) + (i * sizeof(JournalFileEntry)));
+		if(!journal.read(reinterpret_cast<char*>(&entry), sizeof(entry)) || entry.blockSize == 0)
+		{
+			cerr << "Invalid journal file " << m_journalFileName << endl;
+			closeFiles();
+			return jobInfoList;
+		}
+		entry.fileName[JournalFileNameSize - 1] = 0;
+		generations.resize(entry.blocksNumber);
+		journal.seekg(entry.offset);
+		if(!journal.read(reinterpret_cast<char*>(generations.data()), entry.blocksNumber * sizeof(unsigned int)))
+		{
+			cerr << "Journal file " << m_journalFileName << " truncated" << endl;
+			closeFiles();
+			return jobInfoList;
+		}
+		if(filesystem::is_block_file(entry.fileName, errorCode) == false && filesystem::file_size(entry.fileName, errorCode) != entry.fileSize)
+		{
+			cerr << "File " << entry.fileName << " missing or with a size different from the journal" << endl;
+			closeFiles();
+			return jobInfoList;
+		}
+
+		auto &data = verifyData[entry.fileName];
+		auto &systemFile = files[entry.fileName];
+
+		data.fileId = entry.fileId;
+		data.fileSize = entry.fileSize;
+		data.blockSize = entry.blockSize;
+		data.blocksNumber = entry.blocksNumber;
+		data.issuedGenerations.reset(new atomic<unsigned int>[entry.blocksNumber]());
+		data.completedGenerations.reset(new atomic<unsigned int>[entry.blocksNumber]());
+		data.pendingWrites.reset(new atomic<unsigned int>[entry.blocksNumber]());
+		for(unsigned long long n = 0; n < entry.blocksNumber; n++)
+		{
+			// Writes in progress at the crash may be found with any generation after the acknowledged one
+			data.issuedGenerations[n] = (numeric_limits<unsigned int>::max)();
+			data.completedGenerations[n] = generations[n];
+		}
+		systemFile = createSystemFile();
+		if(systemFile->initialize(entry.fileName, true, m_dataSync, entry.fileSize, nullptr, entry.blockSize, true) == false)
+		{
+			closeFiles();
+			return jobInfoList;
+		}
+	}
+
+	m_stop = m_cancel.load();
+	try
+	{
+		for(auto &data : verifyData)
+		{
+			auto job = m_defaultJob;
+			Target target;
+
+			job.taskNumber = taskNumber;
+			target.fileName = data.first;
+			target.systemFile = files[data.first].get();
+			target.verifyData = &data.second;
+			jobInfoList.push_back(verifyFile(target, job));
+			if(m_exception) rethrow_exception(m_exception);
+		}
+	}
+	catch(runtime_error &e)
+	{
+		cerr << "Verify error: " << e.what() << endl;
+		jobInfoList.clear();
+	}
+
+	closeFiles();
+
+	return jobInfoList;
+}
+
+void DiskBenchmark::stop()
+{
+	// Threads end their running operations and the results collected until now are returned
+	m_cancel = true;
+	m_stop = true;
+}
+
+DiskBenchmark::JobSummary DiskBenchmark::summarizeJob(const JobInfo &jobInfo)
+{
+	unsigned long long totalOperations, msCommitDuration = 0;
+	JobSummary summary;
+
+	for(const auto &threadInfo : jobInfo.threadInfoList)
+	{
+		// Thread ended by an error has no operations
+		if(threadInfo.totalReadOperations == 0 && threadInfo.totalWriteOperations == 0 && threadInfo.totalDiscardOperations == 0)
+		{
+			continue;
+		}
+
+		summary.totalReadOperations += threadInfo.totalReadOperations;
+		summary.totalWriteOperations += threadInfo.totalWriteOperations;
+		summary.totalSyncOperations += threadInfo.totalSyncOperations;
+		summary.totalDiscardOperations += threadInfo.totalDiscardOperations;
+		summary.totalCommits += threadInfo.totalCommits;
+		summary.totalVerifiedBlocks += threadInfo.totalVerifiedBlocks;
+		summary.totalVerifyErrors += threadInfo.totalVerifyErrors;
+		if(threadInfo.msDuration > summary.msDuration) summary.msDuration = threadInfo.msDuration;
+		if(threadInfo.msRampDuration > summary.msRampDuration) summary.msRampDuration = threadInfo.msRampDuration;
+		if(threadInfo.totalCommits > 0 && threadInfo.msDuration > msCommitDuration) msCommitDuration = threadInfo.msDuration;
+		summary.readLatency.merge(threadInfo.readLatency);
+		summary.writeLatency.merge(threadInfo.writeLatency);
+		summary.syncLatency.merge(threadInfo.syncLatency);
+		summary.discardLatency.merge(threadInfo.discardLatency);
+		summary.commitLatency.merge(threadInfo.commitLatency);
+	}
+
+	totalOperations = (summary.totalReadOperations + summary.totalWriteOperations + summary.totalDiscardOperations);
+	if(summary.msDuration > 0)
+	{
+		const auto seconds = (static_cast<double>(summary.msDuration) / 1000.0);
+
+		summary.readMBPerSec = ((static_cast<double>(summary.totalReadOperations * jobInfo.blockSize) / (1024.0 * 1024.0)) / seconds);
+		summary.writeMBPerSec = ((static_cast<double>(summary.totalWriteOperations * jobInfo.blockSize) / (1024.0 * 1024.0)) / seconds);
+		summary.iops = ((totalOperations * 1000) / summary.msDuration);
+	}
+	if(msCommitDuration > 0) summary.commitsPerSec = ((summary.totalCommits * 1000) / msCommitDuration);
+
+	return summary;
+}
+
+bool DiskBenchmark::dropCaches()
+{
+	return SystemFile::dropCaches();
+}
+
+unique_ptr<SystemFile> DiskBenchmark::createSystemFile()
+{
+	unique_ptr<SystemFile> systemFile;
+
+	switch(m_engine)
+	{
+		case Engine::System:
+			systemFile.reset(new SystemFile(m_exception));
+			break;
+		case Engine::Null:
+			systemFile.reset(new NullFile(m_exception));
+			break;
+		case Engine::Network:
+		{
+			auto netFile = new NetFile(m_exception);
+
+			netFile->setDepth(m_networkDepth);
+			systemFile.reset(netFile);
+			break;
+		}
+	}
+	systemFile->setLogMsgFunction(m_logMsgFunction);
+
+	return systemFile;
+}
+
+DiskBenchmark::ThreadInfo DiskBenchmark::executeTasks(const TargetList &targets, const Job &job, const OffsetQueue &queue, const OffsetDataList& offsets, ThreadProgress *progress)
+{
+	struct TaskData
+	{
+		enum class State
+		{
+			Null,
+			Read,
+			Write,
+			Discard
+		};
+		State state = State::Null;
+		unsigned int target = 0;
+		unsigned long long address = 0;
+		unsigned int generation = 0;
+		unsigned int issuedGeneration = 0;
+		bool overlapped = false;
+		SystemFile::BlockHandle block;
+		unsigned char *buffer = nullptr;
+		chrono::time_point<chrono::steady_clock> submitTime;
+	};
+	struct SyncData
+	{
+		bool active = false;
+		SystemFile::BlockHandle block;
+		unsigned int writesCounter = 0;
+		chrono::time_point<chrono::steady_clock> submitTime, lastSyncTime;
+	};
+	const auto taskNumber = job.taskNumber;
+	const auto blockSize = job.blockSize;
+	const auto nsSubmitInterval = (job.rateLimit > 0) ? ((1000000000ULL * job.threadNumber) / job.rateLimit) : 0;
+	const auto targetsNumber = static_cast<unsigned int>(targets.size());
+	const auto targetBreakdown = (job.fileNames.size() > 1);
+	const auto dataPattern = (job.compressionRatio > 1.0 || job.dedupePercentage > 0);
+	const auto stampBase = (static_cast<unsigned long long>(random_device{}()) << 32);
+	const auto traceRing = m_eventTrace ? m_eventTrace->createRing() : nullptr;
+	unsigned long long patternBlocksCounter = 0;
+	chrono::time_point<chrono::steady_clock> startTime, measureStartTime, completedTime;
+	unsigned long long submitCounter;
+	SystemFile::BlockHandle *completedBlock;
+	unsigned long long queuePosition, chunkPosition, chunkEnd;
+	int activeTasksCounter;
+	size_t blocksCounter;
+	vector<TaskData> tasks(taskNumber);
+	vector<SystemFile::FileHandle> files;
+	vector<SyncData> syncs(targetsNumber);
+	unsigned char *buffer;
+	ThreadInfo threadInfo;
+	bool running, ramping;
+
+	// Sync is done separately on each file with the intervals counted per file
+	const auto syncActive = [&]()-> bool
+	{
+		return any_of(syncs.begin(), syncs.end(), [](const SyncData &sync) { return sync.active; });
+	};
+	const auto syncPending = [&]()-> bool
+	{
+		return (job.syncType != SyncType::None && any_of(syncs.begin(), syncs.end(), [](const SyncData &sync) { return (sync.writesCounter > 0); }));
+	};
+
+	// Position of the next offset inside the queue, a shared queue is consumed in chunks to limit the contention on the cursor
+	// and only once the ramp time is over, so the measured pass still covers every offset
+	const auto nextQueuePosition = [&]()-> unsigned long long
+	{
+		if(queue.sharedCursor == nullptr || ramping) return queuePosition++;
+		if(chunkPosition == chunkEnd)
+		{
+			chunkPosition = queue.sharedCursor->fetch_add(QueueChunkSize, memory_order_relaxed);
+			chunkEnd = (chunkPosition + QueueChunkSize);
+		}
+		return chunkPosition++;
+	};
+
+	// Operations are counted in the heatmap interval of their submission and in the range of their latency
+	const auto addHeatmap = [&](const chrono::time_point<chrono::steady_clock> &submitTime, unsigned long long nsLatency)
+	{
+		if(m_heatmapMsInterval > 0) threadInfo.latencyHeatmap.add((submitTime > measureStartTime) ? chrono::duration_cast<chrono::nanoseconds>(submitTime - measureStartTime).count() : 0, nsLatency);
+	};
+
+	m_logMsgFunction("Execute task thread started");
+	if(m_heatmapMsInterval > 0) threadInfo.latencyHeatmap = LatencyHeatmap(m_heatmapMsInterval * 1000000ULL);
+	threadInfo.regionOffset = queue.regionOffset;
+	threadInfo.regionSize = queue.regionSize;
+	if(targetBreakdown)
+	{
+		threadInfo.targetInfoList.resize(targetsNumber);
+		for(unsigned int i = 0; i < targetsNumber; i++) threadInfo.targetInfoList[i].fileName = targets[i].fileName;
+	}
+	buffer = targets.front().systemFile->allocateAlignedMemory(blockSize * taskNumber);
+	if(m_crcBlock == false) fillTaskBuffers(buffer, taskNumber, job);
+	for(unsigned int i = 0; i < taskNumber; i++) tasks[i].buffer = &buffer[blockSize * i];
+	try
+	{
+		for(const auto &target : targets) files.push_back(target.systemFile->openFile(taskNumber + ((job.syncType != SyncType::None) ? 1 : 0)));
+
+		running = true;
+		blocksCounter = 0;
+		submitCounter = 0;
+		activeTasksCounter = 0;
+		queuePosition = chunkPosition = chunkEnd = 0;
+		startTime = measureStartTime = chrono::steady_clock::now();
+		ramping = (m_rampSeconds > 0);
+		for(auto &sync : syncs) sync.lastSyncTime = startTime;
+		do
+		{
+			// Operations completed during the ramp time fill queues and caches but are not part of the results
+			if(ramping == true && chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now() - startTime).count() >= m_rampSeconds)
+			{
+				measureStartTime = chrono::steady_clock::now();
+				threadInfo.msRampDuration = chrono::duration_cast<chrono::milliseconds>(measureStartTime - startTime).count();
+				clearThreadInfo(threadInfo);
+				blocksCounter = 0;
+				ramping = false;
+			}
+
+			if(running == true && ramping == false && m_secondsDuration > 0)
+			{
+				running = (chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now() - measureStartTime).count() < m_secondsDuration) ? true : false;
+			}
+			if(running == true && m_stop == true) running = false;
+
+			if(running == true && activeTasksCounter < taskNumber)
+			{
+				for(auto &task : tasks)
+				{
+					if(task.state == TaskData::State::Null)
+					{
+						if(nsSubmitInterval > 0 && static_cast<unsigned long long>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - startTime).count()) < (submitCounter * nsSubmitInterval)) break;
+
+						const auto position = nextQueuePosition();
+
+						// Single pass of a shared queue ends when the threads together have taken every offset
+						if(queue.sharedCursor != nullptr && m_secondsDuration == 0 && ramping == false && position >= queue.size)
+						{
+							running = false;
+							break;
+						}
+
+						const auto offset = offsets.at((queue.startIndex + (position % queue.size)) % offsets.size());
+						const auto systemFile = targets[offset.target].systemFile;
+						const auto verifyData = targets[offset.target].verifyData;
+
+						task.target = offset.target;
+						task.address = offset.address;
+						switch(offset.operation)
+						{
+							case Operation::Read:
+								task.state = TaskData::State::Read;
+								if(verifyData)
+								{
+									const auto index = (offset.address / blockSize);
+
+									// A read overlapping a write may return the block partially written, so it is checked only when
+									// no write of the block is pending at submission and none is issued until its completion
+									task.issuedGeneration = verifyData->issuedGenerations[index].load();
+									task.generation = (verifyData->pendingWrites[index].load() == 0) ? verifyData->completedGenerations[index].load() : 0;
+								}
+								task.submitTime = chrono::steady_clock::now();
+								systemFile->readBlock(files[task.target], offset.address, task.buffer, blockSize, &task.block);
+								break;
+							case Operation::Write:
+								task.state = TaskData::State::Write;
+								if(m_crcBlock) fillBlock(task.buffer, blockSize, true);
+								if(dataPattern) stampBlock(task.buffer, blockSize, job, patternBlocksCounter, stampBase);
+								if(verifyData)
+								{
+									task.overlapped = (verifyData->pendingWrites[offset.address / blockSize].fetch_add(1) > 0);
+									task.generation = (verifyData->issuedGenerations[offset.address / blockSize].fetch_add(1) + 1);
+									writeBlockHeader(task.buffer, blockSize, offset.address, verifyData->fileId, task.generation);
+								}
+								task.submitTime = chrono::steady_clock::now();
+								systemFile->writeBlock(files[task.target], offset.address, task.buffer, blockSize, &task.block);
+								break;
+							case Operation::Discard:
+								task.state = TaskData::State::Discard;
+								task.submitTime = chrono::steady_clock::now();
+								if(systemFile->discardBlock(files[task.target], offset.address, blockSize, &task.block) == false)
+								{
+									completedTime = chrono::steady_clock::now();
+									if(traceRing) traceRing->add(EventTrace::Operation::Discard, EventTrace::Result::Success, task.target, task.address, blockSize, task.submitTime, completedTime);
+									threadInfo.discardLatency.add(chrono::duration_cast<chrono::nanoseconds>(completedTime - task.submitTime).count());
+									addHeatmap(task.submitTime, chrono::duration_cast<chrono::nanoseconds>(completedTime - task.submitTime).count());
+									threadInfo.totalDiscardOperations++;
+									task.state = TaskData::State::Null;
+								}
+								break;
+						}
+						if(task.state != TaskData::State::Null) activeTasksCounter++;
+						submitCounter++;
+
+						if(queue.sharedCursor == nullptr && m_secondsDuration == 0 && ramping == false && ++blocksCounter >= queue.size)
+						{
+							running = false;
+							break;
+						}
+					}
+				}
+			}
+
+			// Nothing to wait for until the next submission allowed by the rate limit
+			if(nsSubmitInterval > 0 && running == true && activeTasksCounter == 0 && syncActive() == false)
+			{
+				this_thread::sleep_until(startTime + chrono::nanoseconds(submitCounter * nsSubmitInterval));
+			}
+
+			for(unsigned int i = 0; job.syncType != SyncType::None && i < targetsNumber; i++)
+			{
+				auto &sync = syncs[i];
+
+				if(sync.active == false && sync.writesCounter > 0)
+				{
+					const auto now = chrono::steady_clock::now();
+
+					if((job.syncWritesInterval > 0 && sync.writesCounter >= job.syncWritesInterval)
+					|| (job.syncMsInterval > 0 && chrono::duration_cast<chrono::milliseconds>(now - sync.lastSyncTime).count() >= job.syncMsInterval)
+					|| (running == false && activeTasksCounter == 0))
+					{
+						sync.writesCounter = 0;
+						sync.submitTime = sync.lastSyncTime = now;
+						sync.active = targets[i].systemFile->syncFile(files[i], (job.syncType == SyncType::Fdatasync), &sync.block);
+						if(sync.active == false)
+						{
+							completedTime = chrono::steady_clock::now();
+							if(traceRing) traceRing->add(EventTrace::Operation::Sync, EventTrace::Result::Success, i, 0, 0, sync.submitTime, completedTime);
+							threadInfo.syncLatency.add(chrono::duration_cast<chrono::nanoseconds>(completedTime - sync.submitTime).count());
+							threadInfo.totalSyncOperations++;
+						}
+					}
+				}
+			}
+			
+			for(unsigned int i = 0; i < targetsNumber; i++)
+			{
+				auto &sync = syncs[i];
+
+				while((completedBlock = targets[i].systemFile->getCompletedBlock(files[i])) != nullptr)
+				{
+					completedTime = chrono::steady_clock::now();
+
+					if(completedBlock == &sync.block)
+					{
+						if(traceRing) traceRing->add(EventTrace::Operation::Sync, EventTrace::Result::Success, i, 0, 0, sync.submitTime, completedTime);
+						threadInfo.syncLatency.add(chrono::duration_cast<chrono::nanoseconds>(completedTime - sync.submitTime).count());
+						threadInfo.totalSyncOperations++;
+						sync.active = false;
+						continue;
+					}
+
+					for(auto &task : tasks)
+					{
+						if(&task.block == completedBlock)
+						{
+							const auto nsLatency = chrono::duration_cast<chrono::nanoseconds>(completedTime - task.submitTime).count();
+							auto result = EventTrace::Result::Success;
+
+							if(m_crcBlock == true && task.state == TaskData::State::Read)
+							{
+								if(!checkCrcBlock(task.buffer, blockSize)) throw runtime_error("Read block crc failed");
+							}
+
+							// Blocks not yet written during the test have no known content to check
+							if(targets[i].verifyData && task.state == TaskData::State::Read && task.generation > 0
+							&& targets[i].verifyData->issuedGenerations[task.address / blockSize].load() == task.issuedGeneration)
+							{
+								const auto maxGeneration = task.issuedGeneration;
+								VerifyError error;
+
+								threadInfo.totalVerifiedBlocks++;
+								if(verifyBlock(task.buffer, blockSize, task.address, targets[i], task.generation, maxGeneration, error) == false)
+								{
+									threadInfo.totalVerifyErrors++;
+									result = EventTrace::Result::VerifyError;
+									if(threadInfo.verifyErrors.size() < MaxVerifyErrors) threadInfo.verifyErrors.push_back(error);
+								}
+							}
+							// Overlapping writes of the same block may reach the device in any order, the last completed generation
+							// is known only for writes without other writes of the block in flight
+							if(targets[i].verifyData && task.state == TaskData::State::Write)
+							{
+								auto &completedGeneration = targets[i].verifyData->completedGenerations[task.address / blockSize];
+								auto generation = completedGeneration.load();
+
+								if(task.overlapped == false && targets[i].verifyData->issuedGenerations[task.address / blockSize].load() == task.generation)
+								{
+									while(generation < task.generation && completedGeneration.compare_exchange_weak(generation, task.generation) == false);
+								}
+								targets[i].verifyData->pendingWrites[task.address / blockSize].fetch_sub(1);
+							}
+
+							if(traceRing)
+							{
+								const auto operation = (task.state == TaskData::State::Read) ? EventTrace::Operation::Read : ((task.state == TaskData::State::Write) ? EventTrace::Operation::Write : EventTrace::Operation::Discard);
+
+								traceRing->add(operation, result, task.target, task.address, blockSize, task.submitTime, completedTime);
+							}
+							addHeatmap(task.submitTime, nsLatency);
+
+							if(task.state == TaskData::State::Discard)
+							{
+								threadInfo.discardLatency.add(nsLatency);
+								threadInfo.totalDiscardOperations++;
+							}
+							else if(task.state == TaskData::State::Read)
+							{
+								threadInfo.readLatency.add(nsLatency);
+								threadInfo.totalReadOperations++;
+								if(targetBreakdown)
+								{
+									threadInfo.targetInfoList[task.target].readLatency.add(nsLatency);
+									threadInfo.targetInfoList[task.target].totalReadOperations++;
+								}
+							}
+							else
+							{
+								threadInfo.writeLatency.add(nsLatency);
+								threadInfo.totalWriteOperations++;
+								if(targetBreakdown)
+								{
+									threadInfo.targetInfoList[task.target].writeLatency.add(nsLatency);
+									threadInfo.targetInfoList[task.target].totalWriteOperations++;
+								}
+								sync.writesCounter++;
+							}
+
+							task.state = TaskData::State::Null;
+							activeTasksCounter--;
+							break;
+						}
+					}
+				}
+			}
+			progress->operations.store(threadInfo.totalReadOperations + threadInfo.totalWriteOperations + threadInfo.totalDiscardOperations, memory_order_relaxed);
+			progress->readOperations.store(threadInfo.totalReadOperations, memory_order_relaxed);
+			progress->writeOperations.store(threadInfo.totalWriteOperations, memory_order_relaxed);
+			progress->discardOperations.store(threadInfo.totalDiscardOperations, memory_order_relaxed);
+		} while(running == true || activeTasksCounter > 0 || syncActive() == true || syncPending() == true);
+		threadInfo.msDuration = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - measureStartTime).count();
+
+		for(unsigned int i = 0; i < targetsNumber; i++) targets[i].systemFile->closeFile(files[i]);
+	}
+	catch(...)
+	{
+		threadInfo.totalReadOperations = threadInfo.totalWriteOperations = threadInfo.totalDiscardOperations = 0;
+		m_exception = current_exception();
+	}
+	targets.front().systemFile->freeAlignedMemory(buffer);
+	m_logMsgFunction("Execute task thread finished");
+
+	return threadInfo;
+}
+
+void DiskBenchmark::executeTasksThread(promise<ThreadInfo> promise, TargetList targets, const Job &job, OffsetQueue queue, const OffsetDataList& offsets, ThreadProgress *progress)
+{
+	promise.set_value(executeTasks(targets, job, queue, offsets, progress));
+}
+
+DiskBenchmark::ProcessResult* DiskBenchmark::startWorkerProcess(WorkerProcess &workerProcess, const WorkerTask &task, size_t targetsNumber)
+{
+	const auto sharedMemorySize = (sizeof(ProcessResult) + (sizeof(ProcessTargetResult) * targetsNumber));
+	ProcessResult *result;
+	ProcessTargetResult *targetResults;
+
+	result = static_cast<ProcessResult*>(workerProcess.allocateSharedMemory(sharedMemorySize));
+	if(result == nullptr)
+	{
+		throw runtime_error("Unable to allocate the results of the worker process");
+	}
+	new (result) ProcessResult();
+	targetResults = reinterpret_cast<ProcessTargetResult*>(result + 1);
+	for(size_t i = 0; i < targetsNumber; i++) new (&targetResults[i]) ProcessTargetResult();
+
+	// Child runs the task on the copy of the test made by the fork and writes the results in shared memory,
+	// the stop request of the main process reaches it through the shared stop flag
+	const auto worker = [&](void*)
+	{
+		atomic<bool> finished(false);
+		thread stopThread([&]()
+		{
+			while(finished == false)
+			{
+				if(result->stop) m_stop = true;
+				this_thread::sleep_for(chrono::milliseconds(ProcessMsInterval));
+			}
+		});
+		const auto processInfo = task(&result->progress);
+
+		finished = true;
+		stopThread.join();
+		if(m_exception)
+		{
+			try
+			{
+				rethrow_exception(m_exception);
+			}
+			catch(exception &e)
+			{
+				strncpy(result->error, e.what(), ProcessErrorSize - 1);
+			}
+			catch(...)
+			{
+				strncpy(result->error, "Unknown error", ProcessErrorSize - 1);
+			}
+			return;
+		}
+
+		result->msDuration = processInfo.msDuration;
+		result->msRampDuration = processInfo.msRampDuration;
+		result->regionOffset = processInfo.regionOffset;
+		result->regionSize = processInfo.regionSize;
+		result->totalReadOperations = processInfo.totalReadOperations;
+		result->totalWriteOperations = processInfo.totalWriteOperations;
+		result->totalSyncOperations = processInfo.totalSyncOperations;
+		result->totalDiscardOperations = processInfo.totalDiscardOperations;
+		result->totalCommits = processInfo.totalCommits;
+		result->readLatency = processInfo.readLatency;
+		result->writeLatency = processInfo.writeLatency;
+		result->syncLatency = processInfo.syncLatency;
+		result->discardLatency = processInfo.discardLatency;
+		result->commitLatency = processInfo.commitLatency;
+		result->targetsNumber = static_cast<unsigned int>(min(processInfo.targetInfoList.size(), targetsNumber));
+		for(unsigned int i = 0; i < result->targetsNumber; i++)
+		{
+			targetResults[i].totalReadOperations = processInfo.targetInfoList[i].totalReadOperations;
+			targetResults[i].totalWriteOperations = processInfo.targetInfoList[i].totalWriteOperations;
+			targetResults[i].readLatency = processInfo.targetInfoList[i].readLatency;
+			targetResults[i].writeLatency = processInfo.targetInfoList[i].writeLatency;
+		}
+		result->completed = true;
+	};
+
+	m_logMsgFunction("Start worker process");
+	if(workerProcess.start(worker) == false)
+	{
+		throw runtime_error("Unable to start the worker process");
+	}
+
+	return result;
+}
+
+void DiskBenchmark::executeProcessThread(promise<ThreadInfo> promise, WorkerProcess *workerProcess, ProcessResult *result, TargetList targets, ThreadProgress *progress)
+{
+	const auto targetResults = reinterpret_cast<ProcessTargetResult*>(result + 1);
+	ThreadInfo threadInfo;
+
+	try
+	{
+		do
+		{
+			this_thread::sleep_for(chrono::milliseconds(ProcessMsInterval));
+			if(m_stop) result->stop = true;
+			progress->operations.store(result->progress.operations.load(), memory_order_relaxed);
+			progress->readOperations.store(result->progress.readOperations.load(), memory_order_relaxed);
+			progress->writeOperations.store(result->progress.writeOperations.load(), memory_order_relaxed);
+			progress->discardOperations.store(result->progress.discardOperations.load(), memory_order_relaxed);
+		} while(workerProcess->isRunning());
+		m_logMsgFunction("Worker process finished");
+
+		if(result->completed == false || workerProcess->exitedNormally() == false)
+		{
+			throw runtime_error((result->error[0] != '\0') ? result->error : "Worker process terminated abnormally");
+		}
+
+		threadInfo.msDuration = result->msDuration;
+		threadInfo.msRampDuration = result->msRampDuration;
+		threadInfo.regionOffset = result->regionOffset;
+		threadInfo.regionSize = result->regionSize;
+		threadInfo.totalReadOperations = result->totalReadOperations;
+		threadInfo.totalWriteOperations = result->totalWriteOperations;
+		threadInfo.totalSyncOperations = result->totalSyncOperations;
+		threadInfo.totalDiscardOperations = result->totalDiscardOperations;
+		threadInfo.totalCommits = result->totalCommits;
+		threadInfo.readLatency = result->readLatency;
+		threadInfo.writeLatency = result->writeLatency;
+		threadInfo.syncLatency = result->syncLatency;
+		threadInfo.discardLatency = result->discardLatency;
+		threadInfo.commitLatency = result->commitLatency;
+		for(unsigned int i = 0; i < result->targetsNumber; i++)
+		{
+			TargetInfo targetInfo;
+
+			targetInfo.fileName = targets[i].fileName;
+			targetInfo.totalReadOperations = targetResults[i].totalReadOperations;
+			targetInfo.totalWriteOperations = targetResults[i].totalWriteOperations;
+			targetInfo.readLatency = targetResults[i].readLatency;
+			targetInfo.writeLatency = targetResults[i].writeLatency;
+			threadInfo.targetInfoList.push_back(targetInfo);
+		}
+	}
+	catch(...)
+	{
+		m_exception = current_exception();
+	}
+	promise.set_value(threadInfo);
+}
+
+DiskBenchmark::ThreadInfo DiskBenchmark::executeAppendTasks(SystemFile *systemFile, const Job &job, unsigned long long startAddress, unsigned long long recordsNumber, ThreadProgress *progress)
+{
+	struct TaskData
+	{
+		bool active = false;
+		SystemFile::BlockHandle block;
+		unsigned long long address = 0;
+		unsigned char *buffer = nullptr;
+		chrono::time_point<chrono::steady_clock> submitTime;
+	};
+	const auto taskNumber = job.taskNumber;
+	const auto blockSize = job.blockSize;
+	const auto nsSubmitInterval = (job.rateLimit > 0) ? ((1000000000ULL * job.threadNumber) / job.rateLimit) : 0;
+	const auto syncType = (job.syncType == SyncType::None) ? SyncType::Fdatasync : job.syncType;
+	const auto dataPattern = (job.compressionRatio > 1.0 || job.dedupePercentage > 0);
+	const auto stampBase = (static_cast<unsigned long long>(random_device{}()) << 32);
+	const auto traceRing = m_eventTrace ? m_eventTrace->createRing() : nullptr;
+	unsigned long long patternBlocksCounter = 0;
+	chrono::time_point<chrono::steady_clock> startTime, measureStartTime, commitStartTime, syncSubmitTime, completedTime;
+	unsigned int activeTasksCounter, groupSubmitted, groupCompleted;
+	unsigned long long address, recordsCounter, recordsLimit;
+	SystemFile::BlockHandle *completedBlock, syncBlock;
+	vector<TaskData> tasks(taskNumber);
+	SystemFile::FileHandle file;
+	unsigned char *buffer;
+	ThreadInfo threadInfo;
+	bool running, ramping, syncActive;
+
+	// Operations are counted in the heatmap interval of their submission and in the range of their latency
+	const auto addHeatmap = [&](const chrono::time_point<chrono::steady_clock> &submitTime, unsigned long long nsLatency)
+	{
+		if(m_heatmapMsInterval > 0) threadInfo.latencyHeatmap.add((submitTime > measureStartTime) ? chrono::duration_cast<chrono::nanoseconds>(submitTime - measureStartTime).count() : 0, nsLatency);
+	};
+	const auto commitCompleted = [&](const chrono::time_point<chrono::steady_clock> &time)
+	{
+		const auto nsLatency = chrono::duration_cast<chrono::nanoseconds>(time - commitStartTime).count();
+
+		threadInfo.commitLatency.add(nsLatency);
+		addHeatmap(commitStartTime, nsLatency);
+		threadInfo.totalCommits++;
+		groupSubmitted = groupCompleted = 0;
+	};
+
+	m_logMsgFunction("Execute append thread started");
+	if(m_heatmapMsInterval > 0) threadInfo.latencyHeatmap = LatencyHeatmap(m_heatmapMsInterval * 1000000ULL);
+	buffer = systemFile->allocateAlignedMemory(blockSize * taskNumber);
+	if(m_crcBlock == false) fillTaskBuffers(buffer, taskNumber, job);
+	for(unsigned int i = 0; i < taskNumber; i++) tasks[i].buffer = &buffer[blockSize * i];
+	try
+	{
+		file = systemFile->openFile(taskNumber + 1);
+
+		running = true;
+		syncActive = false;
+		activeTasksCounter = groupSubmitted = groupCompleted = 0;
+		recordsCounter = 0;
+		recordsLimit = recordsNumber;
+		address = startAddress;
+		startTime = measureStartTime = chrono::steady_clock::now();
+		ramping = (m_rampSeconds > 0);
+		do
+		{
+			if(ramping == true && chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now() - startTime).count() >= m_rampSeconds)
+			{
+				measureStartTime = chrono::steady_clock::now();
+				threadInfo.msRampDuration = chrono::duration_cast<chrono::milliseconds>(measureStartTime - startTime).count();
+				clearThreadInfo(threadInfo);
+				recordsLimit = (recordsCounter + recordsNumber);
+				ramping = false;
+			}
+
+			if(running == true && ramping == false && m_secondsDuration > 0)
+			{
+				running = (chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now() - measureStartTime).count() < m_secondsDuration) ? true : false;
+			}
+			if(running == true && m_stop == true) running = false;
+
+			// Records of a group are appended with up to taskNumber writes in flight, the group is committed when all of them are completed
+			if(running == true && groupSubmitted < job.groupCommit && activeTasksCounter < taskNumber)
+			{
+				for(auto &task : tasks)
+				{
+					if(task.active == false)
+					{
+						if(nsSubmitInterval > 0 && static_cast<unsigned long long>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - startTime).count()) < (recordsCounter * nsSubmitInterval)) break;
+
+						if(m_crcBlock) fillBlock(task.buffer, blockSize, true);
+						if(dataPattern) stampBlock(task.buffer, blockSize, job, patternBlocksCounter, stampBase);
+						task.submitTime = chrono::steady_clock::now();
+						task.address = address;
+						if(groupSubmitted == 0) commitStartTime = task.submitTime;
+						systemFile->writeBlock(file, address, task.buffer, blockSize, &task.block);
+						address += blockSize;
+						task.active = true;
+						activeTasksCounter++;
+						groupSubmitted++;
+
+						if(++recordsCounter >= recordsLimit && m_secondsDuration == 0 && ramping == false) running = false;
+						if(running == false || groupSubmitted >= job.groupCommit) break;
+					}
+				}
+			}
+
+			if(nsSubmitInterval > 0 && running == true && activeTasksCounter == 0 && syncActive == false && groupSubmitted < job.groupCommit)
+			{
+				this_thread::sleep_until(startTime + chrono::nanoseconds(recordsCounter * nsSubmitInterval));
+			}
+
+			if(syncActive == false && groupSubmitted > 0 && groupCompleted == groupSubmitted && (groupSubmitted >= job.groupCommit || running == false))
+			{
+				if(m_dataSync)
+				{
+					commitCompleted(chrono::steady_clock::now());
+				}
+				else
+				{
+					syncSubmitTime = chrono::steady_clock::now();
+					syncActive = systemFile->syncFile(file, (syncType == SyncType::Fdatasync), &syncBlock);
+					if(syncActive == false)
+					{
+						completedTime = chrono::steady_clock::now();
+						if(traceRing) traceRing->add(EventTrace::Operation::Sync, EventTrace::Result::Success, 0, 0, 0, syncSubmitTime, completedTime);
+						threadInfo.syncLatency.add(chrono::duration_cast<chrono::nanoseconds>(completedTime - syncSubmitTime).count());
+						threadInfo.totalSyncOperations++;
+						commitCompleted(completedTime);
+					}
+				}
+			}
+
+			while((completedBlock = systemFile->getCompletedBlock(file)) != nullptr)
+			{
+				completedTime = chrono::steady_clock::now();
+
+				if(completedBlock == &syncBlock)
+				{
+					if(traceRing) traceRing->add(EventTrace::Operation::Sync, EventTrace::Result::Success, 0, 0, 0, syncSubmitTime, completedTime);
+					threadInfo.syncLatency.add(chrono::duration_cast<chrono::nanoseconds>(completedTime - syncSubmitTime).count());
+					threadInfo.totalSyncOperations++;
+					syncActive = false;
+					commitCompleted(completedTime);
+					continue;
+				}
+
+				for(auto &task : tasks)
+				{
+					if(&task.block == completedBlock)
+					{
+						const auto nsLatency = chrono::duration_cast<chrono::nanoseconds>(completedTime - task.submitTime).count();
+
+						if(traceRing) traceRing->add(EventTrace::Operation::Write, EventTrace::Result::Success, 0, task.address, blockSize, task.submitTime, completedTime);
+						addHeatmap(task.submitTime, nsLatency);
+						threadInfo.writeLatency.add(nsLatency);
+						threadInfo.totalWriteOperations++;
+						task.active = false;
+						activeTasksCounter--;
+						groupCompleted++;
+						break;
+					}
+				}
+			}
+			progress->operations.store(threadInfo.totalWriteOperations, memory_order_relaxed);
+			progress->writeOperations.store(threadInfo.totalWriteOperations, memory_order_relaxed);
+		} while(running == true || activeTasksCounter > 0 || syncActive == true || groupSubmitted > 0);
+		threadInfo.msDuration = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - measureStartTime).count();
+
+		systemFile->closeFile(file);
+	}
+	catch(...)
+	{
+		threadInfo.totalReadOperations = threadInfo.totalWriteOperations = 0;
+		m_exception = current_exception();
+	}
+	systemFile->freeAlignedMemory(buffer);
+	m_logMsgFunction("Execute append thread finished");
+
+	return threadInfo;
+}
+
+void DiskBenchmark::executeAppendTasksThread(promise<ThreadInfo> promise, SystemFile *systemFile, const Job &job, unsigned long long startAddress, unsigned long long recordsNumber, ThreadProgress *progress)
+{
+	promise.set_value(executeAppendTasks(systemFile, job, startAddress, recordsNumber, progress));
+}
+
+bool DiskBenchmark::preconditionFiles(const TargetList &targets, const vector<const Job*> &targetJobs)
+{
+	struct ThreadData
+	{
+		unsigned long long blocksNumber = 0;
+		ThreadProgress progress;
+		future<ThreadInfo> status;
+		thread instance;
+		vector<double> samples;
+		unsigned long long lastOperations = 0;
+		bool steadyState = false;
+	};
+	const auto roundSeconds = (m_steadyStateSeconds > 0) ? m_steadyStateSeconds : 1;
+	deque<ThreadData> threads;
+
+	// Every file is written by its own thread with the block size and queue depth of the job using it
+	const auto executePhase = [&](bool randomAccess, unsigned int passes)-> bool
+	{
+		const auto phase = randomAccess ? string("Precondition random writes") : string("Precondition sequential fill");
+		const auto startTime = chrono::steady_clock::now();
+		auto roundTime = (startTime + chrono::seconds(roundSeconds));
+		double percentage = 0.0;
+
+		threads.clear();
+		m_stop = m_cancel.load();
+		for(size_t i = 0; i < targets.size(); i++)
+		{
+			promise<ThreadInfo> promise;
+
+			threads.emplace_back();
+			auto &thread = threads.back();
+			thread.blocksNumber = ((targets[i].systemFile->getFileSize() / targetJobs[i]->blockSize) * passes);
+			thread.status = promise.get_future();
+			thread.instance = std::thread(&DiskBenchmark::executePreconditionTasksThread, this, move(promise), targets[i].systemFile, cref(*targetJobs[i]), randomAccess, thread.blocksNumber, &thread.progress);
+		}
+
+		m_progressFunction(phase, 0.0);
+		while(any_of(threads.begin(), threads.end(), [](const ThreadData &thread) { return thread.instance.joinable(); }))
+		{
+			for(auto &thread : threads)
+			{
+				if(thread.instance.joinable() && thread.status.wait_for(chrono::milliseconds(0)) == future_status::ready) thread.instance.join();
+			}
+			if(m_exception) m_stop = true;
+			if(chrono::steady_clock::now() < roundTime)
+			{
+				this_thread::sleep_for(chrono::milliseconds(10));
+				continue;
+			}
+			roundTime += chrono::seconds(roundSeconds);
+
+			if(randomAccess)
+			{
+				const auto elapsedSeconds = chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now() - startTime).count();
+				bool steadyState = (m_steadyStateSeconds > 0);
+
+				for(auto &thread : threads)
+				{
+					const auto operations = thread.progress.operations.load(memory_order_relaxed);
+					SteadyStateInfo steadyStateInfo;
+
+					thread.samples.push_back(static_cast<double>(operations - thread.lastOperations) / roundSeconds);
+					if(thread.samples.size() > m_steadyStateWindow) thread.samples.erase(thread.samples.begin());
+					thread.lastOperations = operations;
+					thread.steadyState = (thread.samples.size() >= m_steadyStateWindow && checkSteadyState(thread.samples, steadyStateInfo));
+					if(thread.steadyState == false) steadyState = false;
+				}
+				if(steadyState || elapsedSeconds >= m_preconditionSeconds) m_stop = true;
+				percentage = min(100.0, (elapsedSeconds * 100.0) / m_preconditionSeconds);
+			}
+			else
+			{
+				unsigned long long operations = 0, blocksNumber = 0;
+
+				for(const auto &thread : threads)
+				{
+					operations += thread.progress.operations.load(memory_order_relaxed);
+					blocksNumber += thread.blocksNumber;
+				}
+				percentage = ((operations * 100.0) / blocksNumber);
+			}
+			m_progressFunction(phase, percentage);
+		}
+
+		if(m_exception)
+		{
+			return false;
+		}
+		if(randomAccess && m_steadyStateSeconds > 0)
+		{
+			const auto steadyState = all_of(threads.begin(), threads.end(), [](const ThreadData &thread) { return thread.steadyState; });
+
+			m_progressFunction(phase + (steadyState ? " (steady state reached)" : " (steady state not reached)"), 100.0);
+		}
+		else
+		{
+			m_progressFunction(phase, 100.0);
+		}
+
+		return true;
+	};
+
+	m_logMsgFunction("Precondition...");
+	try
+	{
+		if(m_preconditionPasses > 0 && executePhase(false, m_preconditionPasses) == false) rethrow_exception(m_exception);
+		if(m_preconditionSeconds > 0 && executePhase(true, 0) == false) rethrow_exception(m_exception);
+	}
+	catch(runtime_error &e)
+	{
+		cerr << "Precondition error: " << e.what() << endl;
+		m_exception = nullptr;
+		return false;
+	}
+	m_stop = m_cancel.load();
+
+	return true;
+}
+
+DiskBenchmark::ThreadInfo DiskBenchmark::executePreconditionTasks(SystemFile *systemFile, const Job &job, bool randomAccess, unsigned long long blocksNumber, ThreadProgress *progress)
+{
+	struct TaskData
+	{
+		bool active = false;
+		SystemFile::BlockHandle block;
+		unsigned char *buffer = nullptr;
+	};
+	const auto taskNumber = job.taskNumber;
+	const auto blockSize = job.blockSize;
+	const auto fileBlocksNumber = (systemFile->getFileSize() / blockSize);
+	uniform_int_distribution<unsigned long long> randomBlock(0, fileBlocksNumber - 1);
+	default_random_engine randomEngine(random_device{}());
+	chrono::time_point<chrono::steady_clock> startTime;
+	unsigned long long blocksCounter;
+	SystemFile::BlockHandle *completedBlock;
+	unsigned int activeTasksCounter;
+	vector<TaskData> tasks(taskNumber);
+	SystemFile::FileHandle file;
+	unsigned char *buffer;
+	ThreadInfo threadInfo;
+	bool running;
+
+	m_logMsgFunction("Execute precondition thread started");
+	buffer = systemFile->allocateAlignedMemory(blockSize * taskNumber);
+	fillBlock(buffer, blockSize * taskNumber, false);
+	for(unsigned int i = 0; i < taskNumber; i++) tasks[i].buffer = &buffer[blockSize * i];
+	try
+	{
+		file = systemFile->openFile(taskNumber);
+
+		// Offsets are generated while writing, sequential fill wraps around the file for every pass
+		running = (fileBlocksNumber > 0);
+		blocksCounter = 0;
+		activeTasksCounter = 0;
+		startTime = chrono::steady_clock::now();
+		do
+		{
+			if(running == true && m_stop == true) running = false;
+
+			if(running == true && activeTasksCounter < taskNumber)
+			{
+				for(auto &task : tasks)
+				{
+					if(task.active == false)
+					{
+						const auto blockIndex = randomAccess ? randomBlock(randomEngine) : (blocksCounter % fileBlocksNumber);
+
+						systemFile->writeBlock(file, blockIndex * blockSize, task.buffer, blockSize, &task.block);
+						task.active = true;
+						activeTasksCounter++;
+
+						if(++blocksCounter >= blocksNumber && randomAccess == false)
+						{
+							running = false;
+							break;
+						}
+					}
+				}
+			}
+
+			while((completedBlock = systemFile->getCompletedBlock(file)) != nullptr)
+			{
+				for(auto &task : tasks)
+				{
+					if(&task.block == completedBlock)
+					{
+						threadInfo.totalWriteOperations++;
+						task.active = false;
+						activeTasksCounter--;
+						break;
+					}
+				}
+			}
+			progress->operations.store(threadInfo.totalWriteOperations, memory_order_relaxed);
+		} while(running == true || activeTasksCounter > 0);
+		threadInfo.msDuration = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count();
+
+		systemFile->closeFile(file);
+	}
+	catch(...)
+	{
+		threadInfo.totalWriteOperations = 0;
+		m_exception = current_exception();
+	}
+	systemFile->freeAlignedMemory(buffer);
+	m_logMsgFunction("Execute precondition thread finished");
+
+	return threadInfo;
+}
+
+void DiskBenchmark::executePreconditionTasksThread(promise<ThreadInfo> promise, SystemFile *systemFile, const Job &job, bool randomAccess, unsigned long long blocksNumber, ThreadProgress *progress)
+{
+	promise.set_value(executePreconditionTasks(systemFile, job, randomAccess, blocksNumber, progress));
+}
+
+DiskBenchmark::JobInfo DiskBenchmark::verifyFile(const Target &target, Job job)
+{
+	const auto secondsDuration = m_secondsDuration, rampSeconds = m_rampSeconds;
+	ThreadProgress threadProgress;
+	JobInfo jobInfo;
+
+	// Whole file is read sequentially once, without time limit
+	job.name = ("Verify " + target.fileName);
+	job.ioType = IOType::Read;
+	job.threadNumber = 1;
+	job.fileNames = {target.fileName};
+	job.blockSize = target.verifyData->blockSize;
+	job.fileSize = (target.verifyData->blocksNumber * target.verifyData->blockSize);
+	job.randomAccess = false;
+	job.rateLimit = 0;
+	job.syncType = SyncType::None;
+
+	m_logMsgFunction("Verify " + target.fileName);
+	m_secondsDuration = m_rampSeconds = 0;
+	m_stop = m_cancel.load();
+	jobInfo.name = job.name;
+	jobInfo.blockSize = job.blockSize;
+	const auto offsets = calculateOffsets(job.fileSize, job.blockSize, IOType::Read, 100, 0, false);
+
+	jobInfo.threadInfoList.push_back(executeTasks({target}, job, OffsetQueue{0, offsets.size()}, offsets, &threadProgress));
+	m_secondsDuration = secondsDuration;
+	m_rampSeconds = rampSeconds;
+
+	return jobInfo;
+}
+
+unique_ptr<SystemFile> DiskBenchmark::createJournal(map<string, VerifyData> &verifyData, JournalTargetList &journalTargets)
+{
+	unique_ptr<SystemFile> journalFile(new SystemFile(m_exception));
+	const auto pageSize = static_cast<unsigned long long>(journalFile->getMemoryPageSize());
+	const auto headerSize = ((((sizeof(JournalHeader) + (verifyData.size() * sizeof(JournalFileEntry))) + pageSize - 1) / pageSize) * pageSize);
+	unsigned long long journalSize = headerSize;
+	unsigned char *buffer;
+	JournalHeader header;
+	bool result;
+
+	// Journal has a header listing the files followed by the generation of every block of each file
+	journalFile->setLogMsgFunction(m_logMsgFunction);
+	journalTargets.clear();
+	for(auto &data : verifyData)
+	{
+		JournalTarget journalTarget;
+
+		if(data.first.size() >= JournalFileNameSize)
+		{
+			cerr << "File name " << data.first << " too long for the journal" << endl;
+			return nullptr;
+		}
+		journalTarget.verifyData = &data.second;
+		journalTarget.offset = journalSize;
+		journalTargets.push_back(journalTarget);
+		journalSize += ((((data.second.blocksNumber * sizeof(unsigned int)) + pageSize - 1) / pageSize) * pageSize);
+	}
+
+	// Header is followed by an empty page used to initialize the journal content
+	buffer = journalFile->allocateAlignedMemory(headerSize + pageSize);
+	memset(buffer, 0, headerSize + pageSize);
+	header.magic = JournalMagic;
+	header.filesNumber = static_cast<unsigned int>(verifyData.size());
+	memcpy(buffer, &header, sizeof(header));
+	for(size_t i = 0; i < journalTargets.size(); i++)
+	{
+		const auto data = journalTargets[i].verifyData;
+		JournalFileEntry entry;
+
+		memset(&entry, 0, sizeof(entry));
+		for(const auto &file : verifyData)
+		{
+			if(&file.second == data) file.first.copy(entry.fileName, JournalFileNameSize - 1);
+		}
+		entry.fileSize = data->fileSize;
+		entry.blockSize = data->blockSize;
+		entry.blocksNumber = data->blocksNumber;
+		entry.offset = journalTargets[i].offset;
+		entry.fileId = data->fileId;
+		memcpy(buffer + sizeof(header) + (i * sizeof(entry)), &entry, sizeof(entry));
+	}
+
+	// Journal is written bypassing the cache and with synchronous data writes so completed writes are durable
+	result = journalFile->initialize(m_journalFileName, true, true, journalSize, buffer + headerSize, pageSize);
+	if(result)
+	{
+		try
+		{
+			const auto file = journalFile->openFile(1);
+			SystemFile::BlockHandle block;
+
+			journalFile->writeBlock(file, 0, buffer, headerSize, &block);
+			while(journalFile->getCompletedBlock(file) == nullptr) this_thread::yield();
+			journalFile->closeFile(file);
+		}
+		catch(runtime_error &e)
+		{
+			cerr << "Unable to write journal file " << m_journalFileName << ": " << e.what() << endl;
+			journalFile->close(false);
+			result = false;
+		}
+	}
+	journalFile->freeAlignedMemory(buffer);
+
+	return result ? move(journalFile) : nullptr;
+}
+
+void DiskBenchmark::executeJournal(SystemFile *journalFile, const JournalTargetList &journalTargets, const atomic<bool> *stop)
+{
+	const auto pageSize = static_cast<unsigned long long>(journalFile->getMemoryPageSize());
+	const auto pageGenerations = (pageSize / sizeof(unsigned int));
+	auto page = journalFile->allocateAlignedMemory(pageSize);
+	auto generations = reinterpret_cast<unsigned int*>(page);
+	vector<vector<unsigned int>> journaledGenerations;
+	SystemFile::BlockHandle block;
+	bool running = true;
+
+	m_logMsgFunction("Journal thread started");
+	try
+	{
+		const auto file = journalFile->openFile(1);
+
+		for(const auto &journalTarget : journalTargets) journaledGenerations.emplace_back(journalTarget.verifyData->blocksNumber, 0);
+
+		// Generations are copied after the completion of their writes so the journal never contains a write not yet acknowledged,
+		// only the pages changed since the last round are written and the journal is synced at the end of the round
+		while(running)
+		{
+			bool written = false;
+
+			running = (stop->load() == false);
+			for(size_t i = 0; i < journalTargets.size(); i++)
+			{
+				const auto data = journalTargets[i].verifyData;
+
+				for(unsigned long long first = 0; first < data->blocksNumber; first += pageGenerations)
+				{
+					const auto count = min(pageGenerations, data->blocksNumber - first);
+					bool changed = false;
+
+					memset(page, 0, pageSize);
+					for(unsigned long long n = 0; n < count; n++)
+					{
+						generations[n] = data->completedGenerations[first + n].load();
+						if(generations[n] != journaledGenerations[i][first + n]) changed = true;
+					}
+					if(changed == false)
+					{
+						continue;
+					}
+
+					journalFile->writeBlock(file, journalTargets[i].offset + (first * sizeof(unsigned int)), page, pageSize, &block);
+					while(journalFile->getCompletedBlock(file) == nullptr) this_thread::yield();
+					copy(generations, generations + count, journaledGenerations[i].begin() + first);
+					written = true;
+				}
+			}
+			if(written)
+			{
+				if(journalFile->syncFile(file, true, &block))
+				{
+					while(journalFile->getCompletedBlock(file) == nullptr) this_thread::yield();
+				}
+			}
+			if(running) this_thread::sleep_for(chrono::milliseconds(JournalMsInterval));
+		}
+
+		journalFile->closeFile(file);
+	}
+	catch(...)
+	{
+		m_exception = current_exception();
+	}
+	journalFile->freeAlignedMemory(page);
+	m_logMsgFunction("Journal thread finished");
+}
+
+bool DiskBenchmark::checkSteadyState(const vector<double> &samples, SteadyStateInfo &steadyState) const
+{
+	const auto samplesNumber = static_cast<double>(samples.size());
+	const auto minMax = minmax_element(samples.begin(), samples.end());
+	const double xMean = ((samplesNumber - 1.0) / 2.0);
+	double average = 0.0, covariance = 0.0, variance = 0.0;
+
+	for(const auto sample : samples) average += sample;
+	average /= samplesNumber;
+	if(average <= 0.0)
+	{
+		return false;
+	}
+
+	// Like SNIA PTS the values inside the window must stay in a range and the best linear fit must be almost flat
+	for(size_t i = 0; i < samples.size(); i++)
+	{
+		covariance += ((static_cast<double>(i) - xMean) * (samples[i] - average));
+		variance += ((static_cast<double>(i) - xMean) * (static_cast<double>(i) - xMean));
+	}
+	steadyState.averageIOPS = average;
+	steadyState.rangePercentage = (((*minMax.second - *minMax.first) * 100.0) / average);
+	steadyState.slopePercentage = (variance > 0.0) ? ((abs(covariance / variance) * (samplesNumber - 1.0) * 100.0) / average) : 0.0;
+	steadyState.reached = (steadyState.rangePercentage <= m_steadyStateRange && steadyState.slopePercentage <= m_steadyStateSlope);
+
+	return steadyState.reached;
+}
+
+DiskBenchmark::RegionList DiskBenchmark::calculateRegions(const Job &job) const
+{
+	const auto blocksNumber = (job.fileSize / job.blockSize);
+	RegionList regions;
+
+	if(!job.regions.empty())
+	{
+		return job.regions;
+	}
+
+	// File is split in equal parts of whole blocks, the remaining blocks are spread over the regions
+	for(unsigned int i = 0; i < job.threadNumber; i++)
+	{
+		const auto firstBlock = ((blocksNumber * i) / job.threadNumber);
+		const auto lastBlock = ((blocksNumber * (i + 1)) / job.threadNumber);
+		Region region;
+
+		region.offset = (firstBlock * job.blockSize);
+		region.size = ((lastBlock - firstBlock) * job.blockSize);
+		regions.push_back(region);
+	}
+
+	return regions;
+}
+
+void DiskBenchmark::clearThreadInfo(ThreadInfo &threadInfo) const
+{
+	threadInfo.totalReadOperations = threadInfo.totalWriteOperations = 0;
+	threadInfo.totalSyncOperations = threadInfo.totalDiscardOperations = threadInfo.totalCommits = 0;
+	threadInfo.totalVerifiedBlocks = threadInfo.totalVerifyErrors = 0;
+	threadInfo.verifyErrors.clear();
+	threadInfo.readLatency.clear();
+	threadInfo.writeLatency.clear();
+	threadInfo.syncLatency.clear();
+	threadInfo.discardLatency.clear();
+	threadInfo.commitLatency.clear();
+	threadInfo.latencyHeatmap.clear();
+	for(auto &targetInfo : threadInfo.targetInfoList)
+	{
+		targetInfo.totalReadOperations = targetInfo.totalWriteOperations = 0;
+		targetInfo.readLatency.clear();
+		targetInfo.writeLatency.clear();
+	}
+}
+
+DiskBenchmark::OffsetDataList DiskBenchmark::calculateOffsets(unsigned long long fileSize, unsigned long long blockSize, IOType ioType, unsigned char readPercentage, unsigned char discardPercentage, bool randomAccess) const
+{
+	const unsigned long long maxBlocksNumber = (fileSize / blockSize);
+	const unsigned long long maxReadBlocksNumber = ((maxBlocksNumber * readPercentage) / 100);
+	const unsigned long long minDiscardBlockIndex = (maxBlocksNumber - ((maxBlocksNumber * discardPercentage) / 100));
+	OffsetDataList offsets;
+	random_device randomDev;
+	default_random_engine randomEngine(randomDev());
+
+	for(unsigned long long i = 0; i < maxBlocksNumber; i++)
+	{
+		OffsetData offset;
+
+		offset.address = (blockSize * i);
+		switch(ioType)
+		{
+			case IOType::Read:
+				offset.operation = Operation::Read;
+				break;
+			case IOType::Write:
+				offset.operation = (i < minDiscardBlockIndex) ? Operation::Write : Operation::Discard;
+				break;
+			case IOType::ReadWrite:
+				offset.operation = (i < maxReadBlocksNumber) ? Operation::Read : ((i < minDiscardBlockIndex) ? Operation::Write : Operation::Discard);
+				break;
+			case IOType::Append:
+				// Records are appended after the end of the file by their own thread, the offsets are read by the other threads
+				offset.operation = Operation::Read;
+				break;
+		}
+		offsets.push_back(offset);
+	}
+	if(randomAccess)
+	{
+		shuffle(offsets.begin(), offsets.end(), randomEngine);
+	}
+
+	return offsets;
+}
+
+void DiskBenchmark::stripeOffsets(OffsetDataList &offsets, unsigned int targetsNumber, unsigned long long stripeSize) const
+{
+	for(auto &offset : offsets)
+	{
+		const auto stripe = (offset.address / stripeSize);
+
+		offset.target = static_cast<unsigned int>(stripe % targetsNumber);
+		offset.address = (((stripe / targetsNumber) * stripeSize) + (offset.address % stripeSize));
+	}
+}
+
+void DiskBenchmark::fillBlock(unsigned char *block, unsigned long long size, bool crc) const
+{
+	if(crc == true && size > 4)
+	{
+		generate_n(block, size - 4, rand);
+		*(reinterpret_cast<unsigned int*>(&block[size - 4])) = crc32(block, size - 4);
+	}
+	else
+	{
+		generate_n(block, size, rand);
+	}
+}
+
+void DiskBenchmark::fillTaskBuffers(unsigned char *buffer, unsigned int taskNumber, const Job &job) const
+{
+	const auto buffersSize = (job.blockSize * taskNumber);
+	const auto segmentSize = patternSegmentSize(job.blockSize);
+	const auto zeroSize = compressibleSize(segmentSize, job.compressionRatio);
+
+	// Every segment begin with a run of zeros followed by random bytes, the size of the two parts give the requested
+	// compression ratio while the first bytes of the random part hold the stamp making the segment unique when written
+	fillBlock(buffer, buffersSize, false);
+	if(job.compressionRatio <= 1.0 && job.dedupePercentage == 0)
+	{
+		return;
+	}
+	for(unsigned long long offset = 0; offset < buffersSize; offset += segmentSize)
+	{
+		fill_n(&buffer[offset], zeroSize + sizeof(unsigned long long), 0);
+	}
+}
+
+void DiskBenchmark::stampBlock(unsigned char *block, unsigned long long size, const Job &job, unsigned long long &blocksCounter, unsigned long long stampBase) const
+{
+	const auto segmentSize = patternSegmentSize(size);
+	const auto zeroSize = compressibleSize(segmentSize, job.compressionRatio);
+	const auto counter = blocksCounter++;
+	unsigned long long stamp = 0;
+
+	// Duplicated blocks keep the zero stamp of the buffer pool and are spread evenly among the written ones
+	if(((counter + 1) * job.dedupePercentage) / 100 == (counter * job.dedupePercentage) / 100) stamp = (stampBase + ((counter + 1) * (size / segmentSize)));
+	for(unsigned long long offset = 0; offset < size; offset += segmentSize)
+	{
+		memcpy(&block[offset + zeroSize], &stamp, sizeof(stamp));
+		if(stamp > 0) stamp--;
+	}
+}
+
+unsigned long long DiskBenchmark::patternSegmentSize(unsigned long long blockSize) const
+{
+	// Deduplication usually works on 4KB blocks so every 4KB of a bigger block must be unique
+	return (blockSize > 4096 && (blockSize % 4096) == 0) ? 4096 : blockSize;
+}
+
+unsigned long long DiskBenchmark::compressibleSize(unsigned long long segmentSize, double compressionRatio) const
+{
+	const auto zeroSize = static_cast<unsigned long long>(static_cast<double>(segmentSize) * (1.0 - (1.0 / compressionRatio)));
+
+	return (segmentSize > sizeof(unsigned long long)) ? min(zeroSize, segmentSize - sizeof(unsigned long long)) : 0;
+}
+
+bool DiskBenchmark::checkCrcBlock(unsigned char *block, unsigned long long size) const
+{
+	unsigned int crc1, crc2;
+
+	if(size < 4)
+	{
+		return false;
+	}
+
+	crc1 = *(reinterpret_cast<unsigned int*>(&block[size - 4]));
+	crc2 = crc32(block, size - 4);
+
+	return (crc1 == crc2) ? true : false;
+}
+
+void DiskBenchmark::writeBlockHeader(unsigned char *block, unsigned long long size, unsigned long long offset, unsigned int fileId, unsigned int generation) const
+{
+	BlockHeader header;
+
+	header.magic = BlockHeaderMagic;
+	header.checksum = 0;
+	header.offset = offset;
+	header.fileId = fileId;
+	header.generation = generation;
+	memcpy(block, &header, sizeof(header));
+	header.checksum = blockChecksum(block, size);
+	memcpy(block, &header, sizeof(header));
+}
+
+bool DiskBenchmark::verifyBlock(unsigned char *block, unsigned long long size, unsigned long long offset, const Target &target, unsigned int minGeneration, unsigned int maxGeneration, VerifyError &error) const
+{
+	BlockHeader header;
+	unsigned int checksum;
+
+	memcpy(&header, block, sizeof(header));
+	checksum = header.checksum;
+	header.checksum = 0;
+	memcpy(block, &header, sizeof(header));
+
+	error.fileName = target.fileName;
+	error.offset = offset;
+	error.expectedGeneration = minGeneration;
+	error.foundGeneration = header.generation;
+
+	// A block may be found with any generation between the last completed and the last issued write (e.g. writes in progress at a crash)
+	if(header.magic != BlockHeaderMagic)
+	{
+		error.type = VerifyErrorType::Lost;
+		return false;
+	}
+	if(checksum != blockChecksum(block, size))
+	{
+		error.type = VerifyErrorType::Torn;
+		return false;
+	}
+	if(header.offset != offset || header.fileId != target.verifyData->fileId || header.generation > maxGeneration)
+	{
+		error.type = VerifyErrorType::Misplaced;
+		return false;
+	}
+	if(header.generation < minGeneration)
+	{
+		error.type = VerifyErrorType::Stale;
+		return false;
+	}
+
+	return true;
+}
+
+unsigned int DiskBenchmark::blockChecksum(const unsigned char *block, unsigned long long size) const
+{
+	unsigned long long hash = 0xcbf29ce484222325ULL, word;
+
+	// FNV like hash working on 64 bit words, much faster than crc32 for a whole block
+	for(unsigned long long i = 0; (i + sizeof(word)) <= size; i += sizeof(word))
+	{
+		memcpy(&word, &block[i], sizeof(word));
+		hash = ((hash ^ word) * 0x100000001b3ULL);
+		hash ^= (hash >> 29);
+	}
+
+	return static_cast<unsigned int>(hash ^ (hash >> 32));
+}
+
+unsigned int DiskBenchmark::crc32(unsigned char *buffer, unsigned long long size) const
+{
+	const unsigned int table[] = {
+		0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
+		0xe963a535, 0x9e6495a3,	0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
+		0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91, 0x1db71064, 0x6ab020f2,
+		0xf3b97148, 0x84be41de,	0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
+		0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec,	0x14015c4f, 0x63066cd9,
+		0xfa0f3d63, 0x8d080df5,	0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172,
+		0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b,	0x35b5a8fa, 0x42b2986c,
+		0xdbbbc9d6, 0xacbcf940,	0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
+		0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423,
+		0xcfba9599, 0xb8bda50f, 0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924,
+		0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d,	0x76dc4190, 0x01db7106,
+		0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
+		0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818, 0x7f6a0dbb, 0x086d3d2d,
+		0x91646c97, 0xe6635c01, 0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e,
+		0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457, 0x65b0d9c6, 0x12b7e950,
+		0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
+		0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2, 0x4adfa541, 0x3dd895d7,
+		0xa4d1c46d, 0xd3d6f4fb, 0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0,
+		0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cc9, 0x5005713c, 0x270241aa,
+		0xbe0b1010, 0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
+		0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17, 0x2eb40d81,
+		0xb7bd5c3b, 0xc0ba6cad, 0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a,
+		0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683, 0xe3630b12, 0x94643b84,
+		0x0d6d6a3e, 0x7a6a5aa8, 0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
+		0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb,
+		0x196c3671, 0x6e6b06e7, 0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc,
+		0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5, 0xd6d6a3e8, 0xa1d1937e,
+		0x38d8c2c4, 0x4fdff252, 0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
+		0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55,
+		0x316e8eef, 0x4669be79, 0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236,
+		0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f, 0xc5ba3bbe, 0xb2bd0b28,
+		0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
+		0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a, 0x9c0906a9, 0xeb0e363f,
+		0x72076785, 0x05005713, 0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38,
+		0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21, 0x86d3d2d4, 0xf1d4e242,
+		0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
+		0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c, 0x8f659eff, 0xf862ae69,
+		0x616bffd3, 0x166ccf45, 0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2,
+		0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db, 0xaed16a4a, 0xd9d65adc,
+		0x40df0b66, 0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
+		0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693,
+		0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
+		0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
+	};
+	unsigned int crc = 0xFFFFFFFF;
+
+	for(unsigned long long i = 0; i < size; ++i)
+	{
+		crc = (table[(crc ^ buffer[i]) & 0xFF] ^ (crc >> 8));
+	}
+
+	return (crc ^ 0xFFFFFFFF);
+}
@@ -1,63 +1,424 @@
-#pragma once
-
-#include <map>
-#include <vector>
-#include <future>
-
-class SystemFile;
-
-class DiskBenchmark
-{
-	struct OffsetData
-	{
-		unsigned long long address = 0;
-		bool read = true;
-	};
-	using OffsetDataList = std::vector<OffsetData>;
-
-public:
-	DiskBenchmark();
-	~DiskBenchmark();
-
-	using LogMsgFunction = std::function<void(const std::string &logMsg)>;
-
-	enum class IOType
-	{
-		Read = 0,
-		Write,
-		ReadWrite
-	};
-	struct ThreadInfo
-	{
-		unsigned long long msDuration = 0;
-		unsigned int totalReadOperations = 0;
-		unsigned int totalWriteOperations = 0;
-	};
-	using ThreadInfoList = std::vector<ThreadInfo>;
-
-	ThreadInfoList executeTest(IOType ioType, unsigned int threadNumber, unsigned int taskNumber, const std::string &fileName, unsigned long long fileSize, unsigned long long blockSize);
-	void setLogMsgFunction(const LogMsgFunction &logMsgFunction);
-	void setUnalignedOffsets(bool unalignedOffsets);
-	void setRandomAccess(bool randomAccess);
-	void setReadPercentage(unsigned char readPercentage);
-	void setWritePercentage(unsigned char writePercentage);
-	void setSecondsDuration(unsigned int seconds);
-	void setCrcBlockCheck(bool crcBlock);
-	void setUseExistingFile(bool useExistingFile);
-
-private:
-	std::unique_ptr<SystemFile> m_systemFile;
-	std::exception_ptr m_exception;
-	LogMsgFunction m_logMsgFunction;
-	bool m_unalignedOffsets, m_randomAccess, m_crcBlock;
-	unsigned char m_readPercentage;
-	unsigned int m_secondsDuration;
-	bool m_useExistingFile;
-
-	ThreadInfo executeTasks(unsigned int taskNumber, unsigned long long blockSize, unsigned int startOffsetIndex, const OffsetDataList& offsets);
-	void executeTasksThread(std::promise<ThreadInfo> promise, unsigned int taskNumber, unsigned long long blockSize, unsigned int startOffsetIndex, const OffsetDataList &offsets);
-	OffsetDataList calculateOffsets(unsigned long long fileSize, unsigned long long blockSize, IOType ioType, unsigned char readPercentage, bool randomAccess) const;
-	void fillBlock(unsigned char *block, unsigned long long size, bool crc) const;
-	bool checkCrcBlock(unsigned char *block, unsigned long long size) const;
-	unsigned int crc32(unsigned char *buffer, unsigned long long size) const;
+#pragma once
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <future>
+#include "LatencyHistogram.h"
+#include "LatencyHeatmap.h"
+
+class SystemFile;
+class EventTrace;
+class WorkerProcess;
+
+class DiskBenchmark
+{
+	static constexpr unsigned int BlockHeaderMagic = 0x4B424844;
+	static constexpr size_t MaxVerifyErrors = 100;
+	static constexpr unsigned int JournalMagic = 0x4B424A4C;
+	static constexpr unsigned int JournalMsInterval = 10;
+	static constexpr size_t JournalFileNameSize = 256;
+	static constexpr unsigned int QueueChunkSize = 16;
+	static constexpr size_t ProcessErrorSize = 256;
+	static constexpr unsigned int ProcessMsInterval = 10;
+
+	enum class Operation
+	{
+		Read = 0,
+		Write,
+		Discard
+	};
+	struct OffsetData
+	{
+		unsigned long long address = 0;
+		unsigned int target = 0;
+		Operation operation = Operation::Read;
+	};
+	using OffsetDataList = std::vector<OffsetData>;
+	struct OffsetQueue
+	{
+		size_t startIndex = 0;
+		size_t size = 0;
+		std::atomic<unsigned long long> *sharedCursor = nullptr;
+		unsigned long long regionOffset = 0;
+		unsigned long long regionSize = 0;
+	};
+	using OffsetQueueList = std::vector<OffsetQueue>;
+	struct BlockHeader
+	{
+		unsigned int magic;
+		unsigned int checksum;
+		unsigned long long offset;
+		unsigned int fileId;
+		unsigned int generation;
+	};
+	struct VerifyData
+	{
+		unsigned int fileId = 0;
+		unsigned long long fileSize = 0;
+		unsigned long long blockSize = 0;
+		unsigned long long blocksNumber = 0;
+		std::unique_ptr<std::atomic<unsigned int>[]> issuedGenerations;
+		std::unique_ptr<std::atomic<unsigned int>[]> completedGenerations;
+		std::unique_ptr<std::atomic<unsigned int>[]> pendingWrites;
+	};
+	struct JournalHeader
+	{
+		unsigned int magic;
+		unsigned int filesNumber;
+	};
+	struct JournalFileEntry
+	{
+		char fileName[JournalFileNameSize];
+		unsigned long long fileSize;
+		unsigned long long blockSize;
+		unsigned long long blocksNumber;
+		unsigned long long offset;
+		unsigned int fileId;
+		unsigned int reserved;
+	};
+	struct JournalTarget
+	{
+		VerifyData *verifyData = nullptr;
+		unsigned long long offset = 0;
+	};
+	using JournalTargetList = std::vector<JournalTarget>;
+	struct Target
+	{
+		std::string fileName;
+		SystemFile *systemFile = nullptr;
+		VerifyData *verifyData = nullptr;
+	};
+	using TargetList = std::vector<Target>;
+	struct ThreadProgress
+	{
+		std::atomic<unsigned long long> operations{0};
+		std::atomic<unsigned long long> readOperations{0};
+		std::atomic<unsigned long long> writeOperations{0};
+		std::atomic<unsigned long long> discardOperations{0};
+	};
+	struct ProcessTargetResult
+	{
+		unsigned int totalReadOperations = 0;
+		unsigned int totalWriteOperations = 0;
+		LatencyHistogram readLatency;
+		LatencyHistogram writeLatency;
+	};
+	// Results of a worker process written in shared memory, the targets follow the structure
+	struct ProcessResult
+	{
+		ThreadProgress progress;
+		std::atomic<bool> stop{false};
+		std::atomic<bool> completed{false};
+		char error[ProcessErrorSize] = {};
+		unsigned long long msDuration = 0;
+		unsigned long long msRampDuration = 0;
+		unsigned long long regionOffset = 0;
+		unsigned long long regionSize = 0;
+		unsigned int totalReadOperations = 0;
+		unsigned int totalWriteOperations = 0;
+		unsigned int totalSyncOperations = 0;
+		unsigned int totalDiscardOperations = 0;
+		unsigned int totalCommits = 0;
+		unsigned int targetsNumber = 0;
+		LatencyHistogram readLatency;
+		LatencyHistogram writeLatency;
+		LatencyHistogram syncLatency;
+		LatencyHistogram discardLatency;
+		LatencyHistogram commitLatency;
+	};
+
+public:
+	DiskBenchmark();
+	~DiskBenchmark();
+
+	using LogMsgFunction = std::function<void(const std::string &logMsg)>;
+	using ProgressFunction = std::function<void(const std::string &phase, double percentage)>;
+	using StartFunction = std::function<void()>;
+
+	enum class IOType
+	{
+		Read = 0,
+		Write,
+		ReadWrite,
+		Append
+	};
+	enum class Engine
+	{
+		System = 0,
+		Null,
+		Network
+	};
+	enum class SyncType
+	{
+		None = 0,
+		Fsync,
+		Fdatasync
+	};
+	enum class TargetMode
+	{
+		RoundRobin = 0,
+		Stripe,
+		Thread
+	};
+	enum class QueueMode
+	{
+		Thread = 0,
+		Shared,
+		Partition,
+		Region
+	};
+	struct Region
+	{
+		unsigned long long offset = 0;
+		unsigned long long size = 0;
+	};
+	using RegionList = std::vector<Region>;
+	enum class VerifyErrorType
+	{
+		Torn = 0,
+		Misplaced,
+		Stale,
+		Lost
+	};
+	struct VerifyError
+	{
+		std::string fileName;
+		unsigned long long offset = 0;
+		VerifyErrorType type = VerifyErrorType::Torn;
+		unsigned int expectedGeneration = 0;
+		unsigned int foundGeneration = 0;
+	};
+	using VerifyErrorList = std::vector<VerifyError>;
+	struct TargetInfo
+	{
+		std::string fileName;
+		unsigned int totalReadOperations = 0;
+		unsigned int totalWriteOperations = 0;
+		LatencyHistogram readLatency;
+		LatencyHistogram writeLatency;
+	};
+	using TargetInfoList = std::vector<TargetInfo>;
+	struct ThreadInfo
+	{
+		unsigned long long msDuration = 0;
+		unsigned long long msRampDuration = 0;
+		unsigned long long regionOffset = 0;
+		unsigned long long regionSize = 0;
+		unsigned int totalReadOperations = 0;
+		unsigned int totalWriteOperations = 0;
+		unsigned int totalSyncOperations = 0;
+		unsigned int totalDiscardOperations = 0;
+		unsigned int totalCommits = 0;
+		unsigned int totalVerifiedBlocks = 0;
+		unsigned int totalVerifyErrors = 0;
+		LatencyHistogram readLatency;
+		LatencyHistogram writeLatency;
+		LatencyHistogram syncLatency;
+		LatencyHistogram discardLatency;
+		LatencyHistogram commitLatency;
+		LatencyHeatmap latencyHeatmap;
+		TargetInfoList targetInfoList;
+		VerifyErrorList verifyErrors;
+	};
+	using ThreadInfoList = std::vector<ThreadInfo>;
+	struct Job
+	{
+		std::string name;
+		IOType ioType = IOType::Read;
+		unsigned int threadNumber = 1;
+		unsigned int taskNumber = 1;
+		std::vector<std::string> fileNames;
+		TargetMode targetMode = TargetMode::RoundRobin;
+		unsigned long long stripeSize = 0;
+		QueueMode queueMode = QueueMode::Thread;
+		RegionList regions;
+		unsigned long long fileSize = 0;
+		unsigned long long blockSize = 0;
+		unsigned char readPercentage = 50;
+		unsigned char discardPercentage = 0;
+		double compressionRatio = 1.0;
+		unsigned char dedupePercentage = 0;
+		bool randomAccess = false;
+		bool unalignedOffsets = false;
+		unsigned int rateLimit = 0;
+		SyncType syncType = SyncType::None;
+		unsigned int syncWritesInterval = 0;
+		unsigned int syncMsInterval = 0;
+		unsigned int groupCommit = 1;
+	};
+	using JobList = std::vector<Job>;
+	struct SteadyStateInfo
+	{
+		bool reached = false;
+		unsigned int rounds = 0;
+		double averageIOPS = 0.0;
+		double rangePercentage = 0.0;
+		double slopePercentage = 0.0;
+	};
+	struct JobInfo
+	{
+		std::string name;
+		unsigned long long blockSize = 0;
+		ThreadInfoList threadInfoList;
+		SteadyStateInfo steadyState;
+	};
+	using JobInfoList = std::vector<JobInfo>;
+	struct JobProgress
+	{
+		std::string name;
+		unsigned int activeThreads = 0;
+		unsigned long long readOperations = 0;
+		unsigned long long writeOperations = 0;
+		unsigned long long discardOperations = 0;
+	};
+	using JobProgressList = std::vector<JobProgress>;
+	struct ProgressInfo
+	{
+		bool running = false;
+		std::string phase;
+		unsigned long long msPhaseDuration = 0;
+		JobProgressList jobs;
+	};
+	struct JobSummary
+	{
+		unsigned long long msDuration = 0;
+		unsigned long long msRampDuration = 0;
+		unsigned long long totalReadOperations = 0;
+		unsigned long long totalWriteOperations = 0;
+		unsigned long long totalSyncOperations = 0;
+		unsigned long long totalDiscardOperations = 0;
+		unsigned long long totalCommits = 0;
+		unsigned long long totalVerifiedBlocks = 0;
+		unsigned long long totalVerifyErrors = 0;
+		double readMBPerSec = 0.0;
+		double writeMBPerSec = 0.0;
+		unsigned long long iops = 0;
+		unsigned long long commitsPerSec = 0;
+		LatencyHistogram readLatency;
+		LatencyHistogram writeLatency;
+		LatencyHistogram syncLatency;
+		LatencyHistogram discardLatency;
+		LatencyHistogram commitLatency;
+	};
+
+	ThreadInfoList executeTest(IOType ioType, unsigned int threadNumber, unsigned int taskNumber, const std::string &fileName, unsigned long long fileSize, unsigned long long blockSize);
+	JobInfoList executeJobs(JobList jobs);
+	std::future<JobInfoList> startJobs(JobList jobs);
+	ProgressInfo getProgress() const;
+	bool isRunning() const;
+	JobInfoList checkJournal(unsigned int taskNumber);
+	void stop();
+	static JobSummary summarizeJob(const JobInfo &jobInfo);
+	static bool dropCaches();
+	void setLogMsgFunction(const LogMsgFunction &logMsgFunction);
+	void setUnalignedOffsets(bool unalignedOffsets);
+	void setRandomAccess(bool randomAccess);
+	void setReadPercentage(unsigned char readPercentage);
+	void setWritePercentage(unsigned char writePercentage);
+	void setDiscardPercentage(unsigned char discardPercentage);
+	void setCompressionRatio(double compressionRatio);
+	void setDedupePercentage(unsigned char dedupePercentage);
+	void setSecondsDuration(unsigned int seconds);
+	void setRampSeconds(unsigned int seconds);
+	void setPrecondition(unsigned int fillPasses, unsigned int randomSeconds);
+	void setProgressFunction(const ProgressFunction &progressFunction);
+	void setStartFunction(const StartFunction &startFunction);
+	void setSteadyState(unsigned int secondsRound);
+	void setSteadyStateWindow(unsigned int rounds);
+	void setSteadyStateRange(unsigned int percentage);
+	void setSteadyStateSlope(unsigned int percentage);
+	void setCrcBlockCheck(bool crcBlock);
+	void setVerify(bool verify);
+	void setJournal(const std::string &fileName);
+	void setTrace(const std::string &fileName);
+	void setHeatmapInterval(unsigned int milliseconds);
+	void setUseExistingFile(bool useExistingFile);
+	void setEngine(Engine engine);
+	void setSyncType(SyncType syncType);
+	void setSyncWritesInterval(unsigned int writes);
+	void setSyncMsInterval(unsigned int milliseconds);
+	void setDataSync(bool dataSync);
+	void setGroupCommit(unsigned int records);
+	void setRateLimit(unsigned int iops);
+	void setAllowDeviceWrite(bool allowDeviceWrite);
+	void setTargetMode(TargetMode targetMode);
+	void setStripeSize(unsigned long long stripeSize);
+	void setQueueMode(QueueMode queueMode);
+	void setRegions(const RegionList &regions);
+	void setWorkerProcesses(bool workerProcesses);
+	void setNetworkDepth(unsigned int depth);
+
+private:
+	using WorkerTask = std::function<ThreadInfo(ThreadProgress *progress)>;
+
+	std::exception_ptr m_exception;
+	LogMsgFunction m_logMsgFunction;
+	ProgressFunction m_progressFunction;
+	StartFunction m_startFunction;
+	Engine m_engine;
+	Job m_defaultJob;
+	bool m_crcBlock;
+	bool m_verify;
+	std::string m_journalFileName;
+	std::string m_traceFileName;
+	std::unique_ptr<EventTrace> m_eventTrace;
+	unsigned int m_heatmapMsInterval;
+	unsigned int m_secondsDuration;
+	unsigned int m_rampSeconds;
+	unsigned int m_steadyStateSeconds;
+	unsigned int m_steadyStateWindow;
+	unsigned int m_steadyStateRange;
+	unsigned int m_steadyStateSlope;
+	unsigned int m_preconditionPasses;
+	unsigned int m_preconditionSeconds;
+	std::atomic<bool> m_stop;
+	std::atomic<bool> m_cancel;
+	std::atomic<bool> m_running;
+	mutable std::mutex m_progressMutex;
+	std::string m_phase;
+	std::chrono::steady_clock::time_point m_phaseStartTime;
+	std::vector<std::string> m_progressJobNames;
+	std::vector<std::deque<ThreadProgress>> m_progress;
+	bool m_useExistingFile;
+	bool m_dataSync;
+	bool m_allowDeviceWrite;
+	bool m_workerProcesses;
+	unsigned int m_networkDepth;
+
+	bool beginJobs();
+	JobInfoList runJobs(JobList jobs);
+	void setPhase(const std::string &phase);
+	ThreadProgress* addThreadProgress(size_t jobIndex);
+	std::unique_ptr<SystemFile> createSystemFile();
+	ThreadInfo executeTasks(const TargetList &targets, const Job &job, const OffsetQueue &queue, const OffsetDataList& offsets, ThreadProgress *progress);
+	void executeTasksThread(std::promise<ThreadInfo> promise, TargetList targets, const Job &job, OffsetQueue queue, const OffsetDataList &offsets, ThreadProgress *progress);
+	ThreadInfo executeAppendTasks(SystemFile *systemFile, const Job &job, unsigned long long startAddress, unsigned long long recordsNumber, ThreadProgress *progress);
+	void executeAppendTasksThread(std::promise<ThreadInfo> promise, SystemFile *systemFile, const Job &job, unsigned long long startAddress, unsigned long long recordsNumber, ThreadProgress *progress);
+	ProcessResult* startWorkerProcess(WorkerProcess &workerProcess, const WorkerTask &task, size_t targetsNumber);
+	void executeProcessThread(std::promise<ThreadInfo> promise, WorkerProcess *workerProcess, ProcessResult *result, TargetList targets, ThreadProgress *progress);
+	bool preconditionFiles(const TargetList &targets, const std::vector<const Job*> &targetJobs);
+	ThreadInfo executePreconditionTasks(SystemFile *systemFile, const Job &job, bool randomAccess, unsigned long long blocksNumber, ThreadProgress *progress);
+	void executePreconditionTasksThread(std::promise<ThreadInfo> promise, SystemFile *systemFile, const Job &job, bool randomAccess, unsigned long long blocksNumber, ThreadProgress *progress);
+	JobInfo verifyFile(const Target &target, Job job);
+	std::unique_ptr<SystemFile> createJournal(std::map<std::string, VerifyData> &verifyData, JournalTargetList &journalTargets);
+	void executeJournal(SystemFile *journalFile, const JournalTargetList &journalTargets, const std::atomic<bool> *stop);
+	bool checkSteadyState(const std::vector<double> &samples, SteadyStateInfo &steadyState) const;
+	OffsetDataList calculateOffsets(unsigned long long fileSize, unsigned long long blockSize, IOType ioType, unsigned char readPercentage, unsigned char discardPercentage, bool randomAccess) const;
+	RegionList calculateRegions(const Job &job) const;
+	void clearThreadInfo(ThreadInfo &threadInfo) const;
+	void stripeOffsets(OffsetDataList &offsets, unsigned int targetsNumber, unsigned long long stripeSize) const;
+	void fillBlock(unsigned char *block, unsigned long long size, bool crc) const;
+	void fillTaskBuffers(unsigned char *buffer, unsigned int taskNumber, const Job &job) const;
+	void stampBlock(unsigned char *block, unsigned long long size, const Job &job, unsigned long long &blocksCounter, unsigned long long stampBase) const;
+	unsigned long long patternSegmentSize(unsigned long long blockSize) const;
+	unsigned long long compressibleSize(unsigned long long segmentSize, double compressionRatio) const;
+	bool checkCrcBlock(unsigned char *block, unsigned long long size) const;
+	void writeBlockHeader(unsigned char *block, unsigned long long size, unsigned long long offset, unsigned int fileId, unsigned int generation) const;
+	bool verifyBlock(unsigned char *block, unsigned long long size, unsigned long long offset, const Target &target, unsigned int minGeneration, unsigned int maxGeneration, VerifyError &error) const;
+	unsigned int blockChecksum(const unsigned char *block, unsigned long long size) const;
+	unsigned int crc32(unsigned char *buffer, unsigned long long size) const;
 };
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <iostream>
+#include "EventTrace.h"
+
+using namespace std;
+
+EventTrace::Ring::Ring(unsigned short thread) : m_events(new Event[RingSize]),
+												m_thread(thread),
+												m_head(0),
+												m_tail(0),
+												m_dropped(0)
+{
+}
+
+void EventTrace::Ring::add(Operation operation, Result result, unsigned int target, unsigned long long offset, unsigned int size,
+						   const chrono::steady_clock::time_point &submitTime, const chrono::steady_clock::time_point &completeTime)
+{
+	const auto head = m_head.load(memory_order_relaxed);
+	Event *event;
+
+	if(head - m_tail.load(memory_order_acquire) >= RingSize)
+	{
+		m_dropped.fetch_add(1, memory_order_relaxed);
+		return;
+	}
+
+	event = &m_events[head % RingSize];
+	event->nsSubmit = chrono::duration_cast<chrono::nanoseconds>(submitTime - m_startTime).count();
+	event->nsComplete = chrono::duration_cast<chrono::nanoseconds>(completeTime - m_startTime).count();
+	event->offset = offset;
+	event->size = size;
+	event->thread = m_thread;
+	event->target = static_cast<unsigned char>(target);
+	event->operation = static_cast<unsigned char>(operation);
+	event->result = static_cast<unsigned char>(result);
+	m_head.store(head + 1, memory_order_release);
+}
+
+EventTrace::EventTrace() : m_running(false)
+{
+}
+
+EventTrace::~EventTrace()
+{
+	close();
+}
+
+bool EventTrace::open(const string &fileName)
+{
+	Header header;
+
+	close();
+	m_file.open(fileName, ios::binary | ios::trunc);
+	if(!m_file.is_open())
+	{
+		cerr << "Unable to create trace file " << fileName << endl;
+		return false;
+	}
+
+	header.magic = Magic;
+	header.version = Version;
+	header.eventSize = sizeof(Event);
+	m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	m_rings.clear();
+	m_startTime = chrono::steady_clock::now();
+	m_running = true;
+	m_writer = thread(&EventTrace::writeEvents, this);
+
+	return true;
+}
+
+void EventTrace::close()
+{
+	if(m_writer.joinable())
+	{
+		m_running = false;
+		m_writer.join();
+	}
+	if(m_file.is_open()) m_file.close();
+}
+
+EventTrace::Ring* EventTrace::createRing()
+{
+	lock_guard<mutex> lock(m_ringsMutex);
+
+	m_rings.emplace_back(static_cast<unsigned short>(m_rings.size()));
+	m_rings.back().m_startTime = m_startTime;
+
+	return &m_rings.back();
+}
+
+unsigned long long EventTrace::getDroppedEvents() const
+{
+	unsigned long long dropped = 0;
+
+	for(const auto &ring : m_rings) dropped += ring.m_dropped.load();
+
+	return dropped;
+}
+
+void EventTrace::writeEvents()
+{
+	bool running = true;
+
+	// Last round after the stop request saves the events added by the threads before their end
+	while(running)
+	{
+		running = m_running.load();
+		{
+			lock_guard<mutex> lock(m_ringsMutex);
+
+			for(auto &ring : m_rings) flushRing(ring);
+		}
+		if(running) this_thread::sleep_for(chrono::milliseconds(WriterMsInterval));
+	}
+	m_file.flush();
+}
+
+void EventTrace::flushRing(Ring &ring)
+{
+	const auto head = ring.m_head.load(memory_order_acquire);
+	auto tail = ring.m_tail.load(memory_order_relaxed);
+
+	// Events are written in at most two contiguous pieces of the ring
+	while(tail < head)
+	{
+		const auto index = (tail % RingSize);
+		const auto count = min(head - tail, RingSize - index);
+
+		m_file.write(reinterpret_cast<const char*>(&ring.m_events[index]), count * sizeof(Event));
+		tail += count;
+	}
+	ring.m_tail.store(tail, memory_order_release);
+}
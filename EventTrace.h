@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class EventTrace
+{
+	static constexpr unsigned int RingSize = 65536;
+	static constexpr unsigned int WriterMsInterval = 10;
+
+public:
+	EventTrace();
+	~EventTrace();
+
+	static constexpr unsigned int Magic = 0x52544244;
+	static constexpr unsigned int Version = 1;
+
+	enum class Operation
+	{
+		Read = 0,
+		Write,
+		Discard,
+		Sync
+	};
+	enum class Result
+	{
+		Success = 0,
+		VerifyError
+	};
+	struct Header
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned long long eventSize;
+	};
+	struct Event
+	{
+		unsigned long long nsSubmit;
+		unsigned long long nsComplete;
+		unsigned long long offset;
+		unsigned int size;
+		unsigned short thread;
+		unsigned char target;
+		unsigned char operation : 4;
+		unsigned char result : 4;
+	};
+
+	// Single producer single consumer ring, the test thread never waits and events are dropped when the writer is late
+	class Ring
+	{
+		friend class EventTrace;
+
+	public:
+		Ring(unsigned short thread);
+
+		void add(Operation operation, Result result, unsigned int target, unsigned long long offset, unsigned int size,
+				 const std::chrono::steady_clock::time_point &submitTime, const std::chrono::steady_clock::time_point &completeTime);
+
+	private:
+		std::unique_ptr<Event[]> m_events;
+		std::chrono::steady_clock::time_point m_startTime;
+		unsigned short m_thread;
+		alignas(64) std::atomic<unsigned long long> m_head;
+		alignas(64) std::atomic<unsigned long long> m_tail;
+		std::atomic<unsigned long long> m_dropped;
+	};
+
+	bool open(const std::string &fileName);
+	void close();
+	Ring* createRing();
+	unsigned long long getDroppedEvents() const;
+
+private:
+	std::ofstream m_file;
+	std::chrono::steady_clock::time_point m_startTime;
+	std::deque<Ring> m_rings;
+	std::mutex m_ringsMutex;
+	std::atomic<bool> m_running;
+	std::thread m_writer;
+
+	void writeEvents();
+	void flushRing(Ring &ring);
+};
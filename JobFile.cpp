@@ -0,0 +1,477 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "JobFile.h"
+
+using namespace std;
+
+JobFile::JobFile()
+{
+}
+
+JobFile::~JobFile()
+{
+}
+
+bool JobFile::load(const string &fileName, const Test &defaultTest, const DiskBenchmark::Job &defaultJob)
+{
+	ifstream file(fileName);
+
+	m_tests.clear();
+	if(!file.is_open())
+	{
+		cerr << "Unable to open job file " << fileName << endl;
+		return false;
+	}
+
+	return read(file, fileName, defaultTest, defaultJob);
+}
+
+bool JobFile::loadText(const string &text, const Test &defaultTest, const DiskBenchmark::Job &defaultJob)
+{
+	istringstream stream(text);
+
+	m_tests.clear();
+
+	return read(stream, "text", defaultTest, defaultJob);
+}
+
+bool JobFile::read(istream &file, const string &fileName, const Test &defaultTest, const DiskBenchmark::Job &defaultJob)
+{
+	using ParamList = vector<pair<string, string>>;
+	auto globalTest = defaultTest;
+	auto globalJob = defaultJob;
+	string line, sectionName;
+	ParamList sectionParams;
+	unsigned int lineNumber = 0;
+	bool sectionOpen = false;
+
+	// Every section other than [global] is a job, jobs with the same "test" value run concurrently
+	// while tests are executed sequentially in the order they appear inside the file
+	const auto closeSection = [&]()-> bool
+	{
+		auto job = globalJob;
+		string testName = sectionName;
+		Test *test = nullptr;
+
+		if(sectionOpen == false)
+		{
+			return true;
+		}
+		if(sectionName == "global")
+		{
+			for(const auto &param : sectionParams)
+			{
+				if(setTestParam(globalTest, param.first, param.second) == false && setJobParam(globalJob, param.first, param.second) == false)
+				{
+					cerr << "Invalid param '" << param.first << "' in section [global]" << endl;
+					return false;
+				}
+			}
+			return true;
+		}
+
+		job.name = sectionName;
+		for(const auto &param : sectionParams)
+		{
+			if(param.first == "test") testName = param.second;
+		}
+		for(auto &existingTest : m_tests)
+		{
+			if(existingTest.name == testName) test = &existingTest;
+		}
+		if(test == nullptr)
+		{
+			m_tests.push_back(globalTest);
+			test = &m_tests.back();
+			test->name = testName;
+		}
+		for(const auto &param : sectionParams)
+		{
+			if(param.first != "test" && setTestParam(*test, param.first, param.second) == false && setJobParam(job, param.first, param.second) == false)
+			{
+				cerr << "Invalid param '" << param.first << "' in section [" << sectionName << "]" << endl;
+				return false;
+			}
+		}
+		test->jobs.push_back(job);
+
+		return true;
+	};
+
+	while(getline(file, line))
+	{
+		lineNumber++;
+		line = trim(line);
+		if(line.empty() || line[0] == ';' || line[0] == '#')
+		{
+			continue;
+		}
+
+		if(line.front() == '[' && line.back() == ']')
+		{
+			if(closeSection() == false)
+			{
+				return false;
+			}
+			sectionName = trim(line.substr(1, line.size() - 2));
+			sectionParams.clear();
+			sectionOpen = true;
+		}
+		else
+		{
+			const auto separator = line.find('=');
+
+			if(sectionOpen == false || separator == string::npos)
+			{
+				cerr << "Invalid line " << lineNumber << " in job file " << fileName << endl;
+				return false;
+			}
+			sectionParams.push_back(make_pair(trim(line.substr(0, separator)), trim(line.substr(separator + 1))));
+		}
+	}
+	if(closeSection() == false)
+	{
+		return false;
+	}
+
+	if(m_tests.empty())
+	{
+		cerr << "No job defined in job file " << fileName << endl;
+		return false;
+	}
+
+	return true;
+}
+
+const JobFile::TestList& JobFile::getTests() const
+{
+	return m_tests;
+}
+
+void JobFile::apply(const Test &test, DiskBenchmark &diskBenchmark)
+{
+	diskBenchmark.setSecondsDuration(test.secondsDuration);
+	diskBenchmark.setRampSeconds(test.rampSeconds);
+	diskBenchmark.setSteadyState(test.steadyStateSeconds);
+	diskBenchmark.setSteadyStateWindow(test.steadyStateWindow);
+	diskBenchmark.setSteadyStateRange(test.steadyStateRange);
+	diskBenchmark.setSteadyStateSlope(test.steadyStateSlope);
+	diskBenchmark.setPrecondition(test.preconditionPasses, test.preconditionSeconds);
+	diskBenchmark.setUseExistingFile(test.useExistingFile);
+	diskBenchmark.setDataSync(test.dataSync);
+	diskBenchmark.setCrcBlockCheck(test.crcBlockCheck);
+	diskBenchmark.setVerify(test.verify);
+	diskBenchmark.setJournal(test.journalFileName);
+	diskBenchmark.setTrace(test.traceFileName);
+	diskBenchmark.setEngine(test.engine);
+	diskBenchmark.setAllowDeviceWrite(test.allowDeviceWrite);
+	diskBenchmark.setWorkerProcesses(test.workerProcesses);
+	diskBenchmark.setNetworkDepth(test.networkDepth);
+}
+
+string JobFile::toText(const TestList &tests)
+{
+	const char *ioTypes[] = {"r", "w", "rw", "a"};
+	const char *syncTypes[] = {"none", "fsync", "fdatasync"};
+	const char *targetModes[] = {"rr", "stripe", "thread"};
+	const char *queueModes[] = {"thread", "shared", "partition", "region"};
+	const char *engines[] = {"system", "null", "net"};
+	stringstream text;
+
+	// Every job section carries all the params of its test so the text is loaded back without [global] and defaults
+	for(const auto &test : tests)
+	{
+		for(const auto &job : test.jobs)
+		{
+			string fileNames, regions;
+
+			for(const auto &fileName : job.fileNames) fileNames += (fileNames.empty() ? "" : ";") + fileName;
+			for(const auto &region : job.regions) regions += (regions.empty() ? "" : ";") + to_string(region.offset / (1024 * 1024)) + ":" + to_string(region.size / (1024 * 1024));
+
+			text << "[" << job.name << "]" << endl;
+			text << "test=" << test.name << endl;
+			text << "seconds=" << test.secondsDuration << endl;
+			text << "ramp=" << test.rampSeconds << endl;
+			text << "steady_state=" << test.steadyStateSeconds << endl;
+			text << "steady_window=" << test.steadyStateWindow << endl;
+			text << "steady_range=" << test.steadyStateRange << endl;
+			text << "steady_slope=" << test.steadyStateSlope << endl;
+			text << "precondition=" << test.preconditionPasses << endl;
+			text << "precondition_seconds=" << test.preconditionSeconds << endl;
+			text << "use_existing=" << test.useExistingFile << endl;
+			text << "dsync=" << test.dataSync << endl;
+			text << "crc=" << test.crcBlockCheck << endl;
+			text << "verify=" << test.verify << endl;
+			if(!test.journalFileName.empty()) text << "journal=" << test.journalFileName << endl;
+			if(!test.traceFileName.empty()) text << "trace=" << test.traceFileName << endl;
+			text << "allow_device_write=" << test.allowDeviceWrite << endl;
+			text << "processes=" << test.workerProcesses << endl;
+			text << "engine=" << engines[static_cast<int>(test.engine)] << endl;
+			text << "net_depth=" << test.networkDepth << endl;
+			text << "io_type=" << ioTypes[static_cast<int>(job.ioType)] << endl;
+			text << "thread=" << job.threadNumber << endl;
+			text << "task=" << job.taskNumber << endl;
+			text << "file_name=" << fileNames << endl;
+			text << "target_mode=" << targetModes[static_cast<int>(job.targetMode)] << endl;
+			if(job.stripeSize > 0) text << "stripe_size=" << (job.stripeSize / 1024) << endl;
+			text << "queue=" << queueModes[static_cast<int>(job.queueMode)] << endl;
+			if(!regions.empty()) text << "regions=" << regions << endl;
+			text << "file_size=" << (job.fileSize / (1024 * 1024)) << endl;
+			text << "block_size=" << (job.blockSize / 1024) << endl;
+			text << "read_percentage=" << static_cast<unsigned int>(job.readPercentage) << endl;
+			text << "discard_percentage=" << static_cast<unsigned int>(job.discardPercentage) << endl;
+			text << "compress_ratio=" << job.compressionRatio << endl;
+			text << "dedupe_percentage=" << static_cast<unsigned int>(job.dedupePercentage) << endl;
+			text << "random=" << job.randomAccess << endl;
+			text << "unaligned=" << job.unalignedOffsets << endl;
+			text << "rate=" << job.rateLimit << endl;
+			text << "sync=" << syncTypes[static_cast<int>(job.syncType)] << endl;
+			text << "sync_writes=" << job.syncWritesInterval << endl;
+			text << "sync_ms=" << job.syncMsInterval << endl;
+			text << "group_commit=" << job.groupCommit << endl;
+			text << endl;
+		}
+	}
+
+	return text.str();
+}
+
+bool JobFile::setTestParam(Test &test, const string &key, const string &value)
+{
+	try
+	{
+		if(key == "seconds")
+			test.secondsDuration = stoul(value);
+		else if(key == "ramp")
+			test.rampSeconds = stoul(value);
+		else if(key == "steady_state")
+			test.steadyStateSeconds = stoul(value);
+		else if(key == "steady_window" && stoul(value) > 1)
+			test.steadyStateWindow = stoul(value);
+		else if(key == "steady_range")
+			test.steadyStateRange = stoul(value);
+		else if(key == "steady_slope")
+			test.steadyStateSlope = stoul(value);
+		else if(key == "precondition")
+			test.preconditionPasses = stoul(value);
+		else if(key == "precondition_seconds")
+			test.preconditionSeconds = stoul(value);
+		else if(key == "use_existing")
+			test.useExistingFile = (stoul(value) != 0);
+		else if(key == "dsync")
+			test.dataSync = (stoul(value) != 0);
+		else if(key == "crc")
+			test.crcBlockCheck = (stoul(value) != 0);
+		else if(key == "verify")
+			test.verify = (stoul(value) != 0);
+		else if(key == "journal")
+			test.journalFileName = value;
+		else if(key == "trace")
+			test.traceFileName = value;
+		else if(key == "allow_device_write")
+			test.allowDeviceWrite = (stoul(value) != 0);
+		else if(key == "processes")
+			test.workerProcesses = (stoul(value) != 0);
+		else if(key == "engine")
+			return parseEngine(value, test.engine);
+		else if(key == "net_depth")
+			test.networkDepth = stoul(value);
+		else
+			return false;
+	}
+	catch(logic_error&)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+bool JobFile::setJobParam(DiskBenchmark::Job &job, const string &key, const string &value)
+{
+	try
+	{
+		if(key == "name")
+			job.name = value;
+		else if(key == "io_type")
+			return parseIOType(value, job.ioType);
+		else if(key == "thread" && stoul(value) > 0)
+			job.threadNumber = stoul(value);
+		else if(key == "task" && stoul(value) > 0)
+			job.taskNumber = stoul(value);
+		else if(key == "file_name")
+			return parseFileNames(value, job.fileNames);
+		else if(key == "target_mode")
+			return parseTargetMode(value, job.targetMode);
+		else if(key == "queue")
+			return parseQueueMode(value, job.queueMode);
+		else if(key == "regions")
+			return parseRegions(value, job.regions);
+		else if(key == "stripe_size" && stoull(value) > 0)
+			job.stripeSize = (stoull(value) * 1024);
+		else if(key == "file_size")
+			job.fileSize = (stoull(value) * 1024 * 1024);
+		else if(key == "block_size")
+			job.blockSize = (stoull(value) * 1024);
+		else if(key == "read_percentage" && stoul(value) <= 100)
+			job.readPercentage = static_cast<unsigned char>(stoul(value));
+		else if(key == "discard_percentage" && stoul(value) <= 100)
+			job.discardPercentage = static_cast<unsigned char>(stoul(value));
+		else if(key == "compress_ratio" && stod(value) >= 1.0)
+			job.compressionRatio = stod(value);
+		else if(key == "dedupe_percentage" && stoul(value) <= 100)
+			job.dedupePercentage = static_cast<unsigned char>(stoul(value));
+		else if(key == "random")
+			job.randomAccess = (stoul(value) != 0);
+		else if(key == "unaligned")
+			job.unalignedOffsets = (stoul(value) != 0);
+		else if(key == "rate")
+			job.rateLimit = stoul(value);
+		else if(key == "sync")
+			return parseSyncType(value, job.syncType);
+		else if(key == "sync_writes")
+			job.syncWritesInterval = stoul(value);
+		else if(key == "sync_ms")
+			job.syncMsInterval = stoul(value);
+		else if(key == "group_commit" && stoul(value) > 0)
+			job.groupCommit = stoul(value);
+		else
+			return false;
+	}
+	catch(logic_error&)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+bool JobFile::parseIOType(const string &param, DiskBenchmark::IOType &ioType)
+{
+	if(param == "r")
+		ioType = DiskBenchmark::IOType::Read;
+	else if(param == "w")
+		ioType = DiskBenchmark::IOType::Write;
+	else if(param == "rw")
+		ioType = DiskBenchmark::IOType::ReadWrite;
+	else if(param == "a")
+		ioType = DiskBenchmark::IOType::Append;
+	else
+		return false;
+
+	return true;
+}
+
+bool JobFile::parseSyncType(const string &param, DiskBenchmark::SyncType &syncType)
+{
+	if(param == "none")
+		syncType = DiskBenchmark::SyncType::None;
+	else if(param == "fsync")
+		syncType = DiskBenchmark::SyncType::Fsync;
+	else if(param == "fdatasync")
+		syncType = DiskBenchmark::SyncType::Fdatasync;
+	else
+		return false;
+
+	return true;
+}
+
+bool JobFile::parseTargetMode(const string &param, DiskBenchmark::TargetMode &targetMode)
+{
+	if(param == "rr")
+		targetMode = DiskBenchmark::TargetMode::RoundRobin;
+	else if(param == "stripe")
+		targetMode = DiskBenchmark::TargetMode::Stripe;
+	else if(param == "thread")
+		targetMode = DiskBenchmark::TargetMode::Thread;
+	else
+		return false;
+
+	return true;
+}
+
+bool JobFile::parseQueueMode(const string &param, DiskBenchmark::QueueMode &queueMode)
+{
+	if(param == "thread")
+		queueMode = DiskBenchmark::QueueMode::Thread;
+	else if(param == "shared")
+		queueMode = DiskBenchmark::QueueMode::Shared;
+	else if(param == "partition")
+		queueMode = DiskBenchmark::QueueMode::Partition;
+	else if(param == "region")
+		queueMode = DiskBenchmark::QueueMode::Region;
+	else
+		return false;
+
+	return true;
+}
+
+bool JobFile::parseFileNames(const string &param, vector<string> &fileNames)
+{
+	stringstream paramStream(param);
+	string fileName;
+
+	// Several files are separated by ';' since ',' already separate the params of a job on command line
+	fileNames.clear();
+	while(getline(paramStream, fileName, ';'))
+	{
+		fileName = trim(fileName);
+		if(!fileName.empty()) fileNames.push_back(fileName);
+	}
+
+	return !fileNames.empty();
+}
+
+bool JobFile::parseRegions(const string &param, DiskBenchmark::RegionList &regions)
+{
+	stringstream paramStream(param);
+	string regionParam;
+
+	// Every region is offset:size in Mb, regions of the threads are separated by ';' like the file names
+	regions.clear();
+	while(getline(paramStream, regionParam, ';'))
+	{
+		const auto separator = regionParam.find(':');
+		DiskBenchmark::Region region;
+
+		regionParam = trim(regionParam);
+		if(regionParam.empty()) continue;
+		if(separator == string::npos) return false;
+		try
+		{
+			region.offset = (stoull(regionParam.substr(0, separator)) * 1024 * 1024);
+			region.size = (stoull(regionParam.substr(separator + 1)) * 1024 * 1024);
+		}
+		catch(logic_error&)
+		{
+			return false;
+		}
+		if(region.size == 0) return false;
+		regions.push_back(region);
+	}
+
+	return !regions.empty();
+}
+
+bool JobFile::parseEngine(const string &param, DiskBenchmark::Engine &engine)
+{
+	if(param == "system")
+		engine = DiskBenchmark::Engine::System;
+	else if(param == "null")
+		engine = DiskBenchmark::Engine::Null;
+	else if(param == "net")
+		engine = DiskBenchmark::Engine::Network;
+	else
+		return false;
+
+	return true;
+}
+
+string JobFile::trim(const string &text)
+{
+	const auto first = text.find_first_not_of(" \t\r");
+	const auto last = text.find_last_not_of(" \t\r");
+
+	return (first == string::npos) ? string() : text.substr(first, last - first + 1);
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <istream>
+#include <string>
+#include <vector>
+#include "DiskBenchmark.h"
+
+class JobFile
+{
+public:
+	JobFile();
+	~JobFile();
+
+	struct Test
+	{
+		std::string name;
+		unsigned int secondsDuration = 0;
+		unsigned int rampSeconds = 0;
+		unsigned int steadyStateSeconds = 0;
+		unsigned int steadyStateWindow = 5;
+		unsigned int steadyStateRange = 20;
+		unsigned int steadyStateSlope = 10;
+		unsigned int preconditionPasses = 0;
+		unsigned int preconditionSeconds = 0;
+		bool useExistingFile = false;
+		bool dataSync = false;
+		bool crcBlockCheck = false;
+		bool verify = false;
+		std::string journalFileName;
+		std::string traceFileName;
+		bool allowDeviceWrite = false;
+		bool workerProcesses = false;
+		unsigned int networkDepth = 0;
+		DiskBenchmark::Engine engine = DiskBenchmark::Engine::System;
+		DiskBenchmark::JobList jobs;
+	};
+	using TestList = std::vector<Test>;
+
+	bool load(const std::string &fileName, const Test &defaultTest, const DiskBenchmark::Job &defaultJob);
+	bool loadText(const std::string &text, const Test &defaultTest, const DiskBenchmark::Job &defaultJob);
+	const TestList& getTests() const;
+
+	static void apply(const Test &test, DiskBenchmark &diskBenchmark);
+	static std::string toText(const TestList &tests);
+	static bool setTestParam(Test &test, const std::string &key, const std::string &value);
+	static bool setJobParam(DiskBenchmark::Job &job, const std::string &key, const std::string &value);
+	static bool parseIOType(const std::string &param, DiskBenchmark::IOType &ioType);
+	static bool parseSyncType(const std::string &param, DiskBenchmark::SyncType &syncType);
+	static bool parseTargetMode(const std::string &param, DiskBenchmark::TargetMode &targetMode);
+	static bool parseQueueMode(const std::string &param, DiskBenchmark::QueueMode &queueMode);
+	static bool parseRegions(const std::string &param, DiskBenchmark::RegionList &regions);
+	static bool parseFileNames(const std::string &param, std::vector<std::string> &fileNames);
+	static bool parseEngine(const std::string &param, DiskBenchmark::Engine &engine);
+
+private:
+	TestList m_tests;
+
+	bool read(std::istream &file, const std::string &fileName, const Test &defaultTest, const DiskBenchmark::Job &defaultJob);
+	static std::string trim(const std::string &text);
+};
\ No newline at end of file
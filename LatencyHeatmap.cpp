@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "LatencyHeatmap.h"
+
+using namespace std;
+
+LatencyHeatmap::LatencyHeatmap(unsigned long long nsInterval) : m_nsInterval((nsInterval > 0) ? nsInterval : 1)
+{
+}
+
+void LatencyHeatmap::add(unsigned long long nsTime, unsigned long long nsLatency)
+{
+	const auto interval = (nsTime / m_nsInterval);
+
+	if(interval >= m_intervals.size()) m_intervals.resize(interval + 1, Buckets{});
+	m_intervals[interval][bucketIndex(nsLatency)]++;
+}
+
+void LatencyHeatmap::merge(const LatencyHeatmap &heatmap)
+{
+	if(heatmap.m_intervals.size() > m_intervals.size()) m_intervals.resize(heatmap.m_intervals.size(), Buckets{});
+	for(size_t i = 0; i < heatmap.m_intervals.size(); i++)
+	{
+		for(unsigned int n = 0; n < BucketsNumber; n++) m_intervals[i][n] += heatmap.m_intervals[i][n];
+	}
+}
+
+void LatencyHeatmap::clear()
+{
+	m_intervals.clear();
+}
+
+unsigned long long LatencyHeatmap::interval() const
+{
+	return m_nsInterval;
+}
+
+bool LatencyHeatmap::empty() const
+{
+	return m_intervals.empty();
+}
+
+void LatencyHeatmap::save(ostream &stream) const
+{
+	stream << m_nsInterval << " " << m_intervals.size();
+	for(const auto &buckets : m_intervals)
+	{
+		stream << " " << count_if(buckets.begin(), buckets.end(), [](unsigned long long bucket) { return (bucket > 0); });
+		for(unsigned int i = 0; i < BucketsNumber; i++)
+		{
+			if(buckets[i] > 0) stream << " " << i << " " << buckets[i];
+		}
+	}
+	stream << "\n";
+}
+
+bool LatencyHeatmap::load(istream &stream)
+{
+	size_t intervalsNumber;
+	unsigned int usedBuckets, index;
+
+	if(!(stream >> m_nsInterval >> intervalsNumber) || m_nsInterval == 0)
+	{
+		return false;
+	}
+	// Intervals are added while they are read, a wrong number in the stream can't allocate memory without data
+	m_intervals.clear();
+	for(size_t n = 0; n < intervalsNumber; n++)
+	{
+		auto &buckets = m_intervals.emplace_back();
+
+		if(!(stream >> usedBuckets)) return false;
+		for(unsigned int i = 0; i < usedBuckets; i++)
+		{
+			if(!(stream >> index) || index >= BucketsNumber || !(stream >> buckets[index])) return false;
+		}
+	}
+
+	return true;
+}
+
+bool LatencyHeatmap::writeCsv(const string &fileName) const
+{
+	ofstream file(fileName);
+	unsigned int firstBucket, lastBucket;
+	const auto used = usedBuckets(firstBucket, lastBucket);
+
+	if(!file.is_open())
+	{
+		cerr << "Unable to create heatmap file " << fileName << endl;
+		return false;
+	}
+
+	// Only the range of buckets with at least one operation is written, columns are labeled with the bucket upper bound
+	file << "time_s";
+	for(unsigned int n = firstBucket; used && n <= lastBucket; n++) file << "," << bucketLabel(n);
+	file << endl;
+	for(size_t i = 0; i < m_intervals.size(); i++)
+	{
+		file << (static_cast<double>(i * m_nsInterval) / 1000000000.0);
+		for(unsigned int n = firstBucket; used && n <= lastBucket; n++) file << "," << m_intervals[i][n];
+		file << endl;
+	}
+
+	return true;
+}
+
+bool LatencyHeatmap::writeSvg(const string &fileName, const string &title) const
+{
+	static constexpr unsigned int MarginLeft = 80, MarginTop = 40, MarginBottom = 40, CellHeight = 16, MaxWidth = 1200;
+	ofstream file(fileName);
+	unsigned int firstBucket, lastBucket, cellWidth, width, height, labelStep;
+	unsigned long long maxCount = 0;
+	const auto used = usedBuckets(firstBucket, lastBucket);
+
+	if(!file.is_open())
+	{
+		cerr << "Unable to create heatmap file " << fileName << endl;
+		return false;
+	}
+	if(used == false)
+	{
+		firstBucket = lastBucket = 0;
+	}
+
+	for(const auto &buckets : m_intervals) maxCount = max(maxCount, *max_element(buckets.begin(), buckets.end()));
+	cellWidth = max(1U, min(20U, static_cast<unsigned int>(MaxWidth / max<size_t>(1, m_intervals.size()))));
+	width = (MarginLeft + (cellWidth * static_cast<unsigned int>(m_intervals.size())) + 20);
+	height = (MarginTop + (CellHeight * (lastBucket - firstBucket + 1)) + MarginBottom);
+	labelStep = max(1U, (60 / cellWidth));
+
+	// Color of every cell goes from light yellow to dark red with the logarithm of its operations, longer latencies are at the top
+	file << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << width << "\" height=\"" << height << "\" font-family=\"sans-serif\" font-size=\"11\">" << endl;
+	file << "<rect width=\"100%\" height=\"100%\" fill=\"white\"/>" << endl;
+	file << "<text x=\"" << MarginLeft << "\" y=\"20\" font-size=\"14\">" << escapeXml(title) << " (operations per " << (static_cast<double>(m_nsInterval) / 1000000.0) << " ms and latency range)</text>" << endl;
+	for(size_t i = 0; i < m_intervals.size(); i++)
+	{
+		const auto x = (MarginLeft + (static_cast<unsigned int>(i) * cellWidth));
+
+		for(unsigned int n = firstBucket; used && n <= lastBucket; n++)
+		{
+			const auto count = m_intervals[i][n];
+			const auto y = (MarginTop + ((lastBucket - n) * CellHeight));
+			double level;
+
+			if(count == 0) continue;
+			level = (log(static_cast<double>(count) + 1.0) / log(static_cast<double>(maxCount) + 1.0));
+			file << "<rect x=\"" << x << "\" y=\"" << y << "\" width=\"" << cellWidth << "\" height=\"" << CellHeight << "\" fill=\"rgb("
+				 << static_cast<int>(255 - (level * 127)) << "," << static_cast<int>(240 - (level * 240)) << "," << static_cast<int>(160 - (level * 160))
+				 << ")\"><title>" << (static_cast<double>(i * m_nsInterval) / 1000000000.0) << " s, " << escapeXml(bucketLabel(n)) << ": " << count << "</title></rect>" << endl;
+		}
+		if((i % labelStep) == 0)
+		{
+			file << "<text x=\"" << x << "\" y=\"" << (height - MarginBottom + 15) << "\">" << (static_cast<double>(i * m_nsInterval) / 1000000000.0) << "s</text>" << endl;
+		}
+	}
+	for(unsigned int n = firstBucket; used && n <= lastBucket; n++)
+	{
+		file << "<text x=\"" << (MarginLeft - 5) << "\" y=\"" << (MarginTop + ((lastBucket - n) * CellHeight) + 12) << "\" text-anchor=\"end\">" << escapeXml(bucketLabel(n)) << "</text>" << endl;
+	}
+	file << "</svg>" << endl;
+
+	return true;
+}
+
+bool LatencyHeatmap::usedBuckets(unsigned int &firstBucket, unsigned int &lastBucket) const
+{
+	firstBucket = BucketsNumber;
+	lastBucket = 0;
+	for(const auto &buckets : m_intervals)
+	{
+		for(unsigned int n = 0; n < BucketsNumber; n++)
+		{
+			if(buckets[n] == 0) continue;
+			if(n < firstBucket) firstBucket = n;
+			if(n > lastBucket) lastBucket = n;
+		}
+	}
+
+	return (firstBucket < BucketsNumber);
+}
+
+string LatencyHeatmap::bucketLabel(unsigned int index) const
+{
+	stringstream label;
+
+	if(index == (BucketsNumber - 1))
+		label << ">=" << (static_cast<double>(bucketValue(index - 1)) / 1000.0) << "us";
+	else
+		label << "<" << (static_cast<double>(bucketValue(index)) / 1000.0) << "us";
+
+	return label.str();
+}
+
+string LatencyHeatmap::escapeXml(const string &text)
+{
+	string escapedText;
+
+	for(const auto character : text)
+	{
+		if(character == '<')
+			escapedText += "&lt;";
+		else if(character == '>')
+			escapedText += "&gt;";
+		else if(character == '&')
+			escapedText += "&amp;";
+		else
+			escapedText += character;
+	}
+
+	return escapedText;
+}
+
+unsigned int LatencyHeatmap::bucketIndex(unsigned long long nsLatency) const
+{
+	unsigned int index = 0;
+
+	// Every bucket doubles the latency range of the previous one, the last bucket collects all the longer operations
+	while(index < (BucketsNumber - 1) && nsLatency >= bucketValue(index)) index++;
+
+	return index;
+}
+
+unsigned long long LatencyHeatmap::bucketValue(unsigned int index) const
+{
+	return (NsFirstBucket << index);
+}
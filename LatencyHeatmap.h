@@ -0,0 +1,37 @@
+#pragma once
+
+#include <array>
+#include <iostream>
+#include <string>
+#include <vector>
+
+class LatencyHeatmap
+{
+	static constexpr unsigned int BucketsNumber = 32;
+	static constexpr unsigned long long NsFirstBucket = 250;
+
+public:
+	LatencyHeatmap(unsigned long long nsInterval = 1000000000);
+
+	void add(unsigned long long nsTime, unsigned long long nsLatency);
+	void merge(const LatencyHeatmap &heatmap);
+	void clear();
+	unsigned long long interval() const;
+	bool empty() const;
+	void save(std::ostream &stream) const;
+	bool load(std::istream &stream);
+	bool writeCsv(const std::string &fileName) const;
+	bool writeSvg(const std::string &fileName, const std::string &title) const;
+
+private:
+	using Buckets = std::array<unsigned long long, BucketsNumber>;
+
+	unsigned long long m_nsInterval;
+	std::vector<Buckets> m_intervals;
+
+	bool usedBuckets(unsigned int &firstBucket, unsigned int &lastBucket) const;
+	std::string bucketLabel(unsigned int index) const;
+	static std::string escapeXml(const std::string &text);
+	unsigned int bucketIndex(unsigned long long nsLatency) const;
+	unsigned long long bucketValue(unsigned int index) const;
+};
@@ -0,0 +1,148 @@
+#include <iomanip>
+#include <limits>
+#include "LatencyHistogram.h"
+
+using namespace std;
+
+LatencyHistogram::LatencyHistogram()
+{
+	clear();
+}
+
+void LatencyHistogram::add(unsigned long long nsLatency)
+{
+	m_buckets[bucketIndex(nsLatency)]++;
+	if(nsLatency < m_min) m_min = nsLatency;
+	if(nsLatency > m_max) m_max = nsLatency;
+	m_sum += static_cast<double>(nsLatency);
+	m_count++;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &histogram)
+{
+	for(unsigned int i = 0; i < BucketsNumber; i++) m_buckets[i] += histogram.m_buckets[i];
+	if(histogram.m_min < m_min) m_min = histogram.m_min;
+	if(histogram.m_max > m_max) m_max = histogram.m_max;
+	m_sum += histogram.m_sum;
+	m_count += histogram.m_count;
+}
+
+void LatencyHistogram::clear()
+{
+	m_buckets.fill(0);
+	m_count = 0;
+	m_min = numeric_limits<unsigned long long>::max();
+	m_max = 0;
+	m_sum = 0.0;
+}
+
+unsigned long long LatencyHistogram::count() const
+{
+	return m_count;
+}
+
+unsigned long long LatencyHistogram::min() const
+{
+	return (m_count > 0) ? m_min : 0;
+}
+
+unsigned long long LatencyHistogram::max() const
+{
+	return m_max;
+}
+
+void LatencyHistogram::save(ostream &stream) const
+{
+	unsigned int usedBuckets = 0;
+
+	// Only the buckets with values are written as index and count pairs
+	for(const auto bucket : m_buckets) if(bucket > 0) usedBuckets++;
+	stream << m_count << " " << m_min << " " << m_max << " " << setprecision(17) << m_sum << " " << usedBuckets;
+	for(unsigned int i = 0; i < BucketsNumber; i++)
+	{
+		if(m_buckets[i] > 0) stream << " " << i << " " << m_buckets[i];
+	}
+	stream << "\n";
+}
+
+bool LatencyHistogram::load(istream &stream)
+{
+	unsigned int usedBuckets, index;
+
+	clear();
+	if(!(stream >> m_count >> m_min >> m_max >> m_sum >> usedBuckets))
+	{
+		return false;
+	}
+	for(unsigned int i = 0; i < usedBuckets; i++)
+	{
+		if(!(stream >> index) || index >= BucketsNumber || !(stream >> m_buckets[index])) return false;
+	}
+
+	return true;
+}
+
+double LatencyHistogram::mean() const
+{
+	return (m_count > 0) ? (m_sum / static_cast<double>(m_count)) : 0.0;
+}
+
+unsigned long long LatencyHistogram::percentile(double percentage) const
+{
+	unsigned long long threshold, counter = 0;
+
+	if(m_count == 0)
+	{
+		return 0;
+	}
+
+	threshold = static_cast<unsigned long long>((static_cast<double>(m_count) * percentage) / 100.0);
+	if(threshold == 0) threshold = 1;
+	if(threshold > m_count) threshold = m_count;
+
+	for(unsigned int i = 0; i < BucketsNumber; i++)
+	{
+		counter += m_buckets[i];
+		if(counter >= threshold)
+		{
+			const auto value = bucketValue(i);
+
+			// Bucket value is an approximation so keep it inside the real measured range
+			if(value < m_min) return m_min;
+			if(value > m_max) return m_max;
+			return value;
+		}
+	}
+
+	return m_max;
+}
+
+unsigned int LatencyHistogram::bucketIndex(unsigned long long value) const
+{
+	unsigned int msb = 0;
+
+	if(value < SubBucketsNumber)
+	{
+		return static_cast<unsigned int>(value);
+	}
+
+	for(unsigned int shift : {32, 16, 8, 4, 2, 1})
+	{
+		if((value >> (msb + shift)) != 0) msb += shift;
+	}
+
+	return (((msb - SubBucketBits + 1) * SubBucketsNumber) + static_cast<unsigned int>((value >> (msb - SubBucketBits)) - SubBucketsNumber));
+}
+
+unsigned long long LatencyHistogram::bucketValue(unsigned int index) const
+{
+	const unsigned int group = (index / SubBucketsNumber);
+	const unsigned long long subBucket = (index % SubBucketsNumber);
+
+	if(group == 0)
+	{
+		return subBucket;
+	}
+
+	return (((SubBucketsNumber + subBucket) << (group - 1)) + ((1ULL << (group - 1)) / 2));
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <array>
+#include <iostream>
+
+class LatencyHistogram
+{
+	static constexpr unsigned int SubBucketBits = 5;
+	static constexpr unsigned int SubBucketsNumber = (1 << SubBucketBits);
+	static constexpr unsigned int BucketsNumber = ((64 - SubBucketBits + 1) * SubBucketsNumber);
+
+public:
+	LatencyHistogram();
+
+	void add(unsigned long long nsLatency);
+	void merge(const LatencyHistogram &histogram);
+	void clear();
+	unsigned long long count() const;
+	unsigned long long min() const;
+	unsigned long long max() const;
+	double mean() const;
+	unsigned long long percentile(double percentage) const;
+	void save(std::ostream &stream) const;
+	bool load(std::istream &stream);
+
+private:
+	std::array<unsigned long long, BucketsNumber> m_buckets;
+	unsigned long long m_count, m_min, m_max;
+	double m_sum;
+
+	unsigned int bucketIndex(unsigned long long value) const;
+	unsigned long long bucketValue(unsigned int index) const;
+};
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include "BlockFile.h"
+
+using namespace std;
+
+BlockFile::BlockFile() : m_hFile(-1)
+{
+}
+
+BlockFile::~BlockFile()
+{
+	close();
+}
+
+bool BlockFile::open(const string &fileName, bool dataSync)
+{
+	close();
+	m_hFile = ::open(fileName.c_str(), O_RDWR | (dataSync ? O_DSYNC : 0));
+
+	return (m_hFile != -1);
+}
+
+void BlockFile::close()
+{
+	if(m_hFile != -1)
+	{
+		::close(m_hFile);
+		m_hFile = -1;
+	}
+}
+
+bool BlockFile::isOpen() const
+{
+	return (m_hFile != -1);
+}
+
+bool BlockFile::read(unsigned long long offset, unsigned char *data, unsigned long long size)
+{
+	// Positional I/O may transfer less than asked, the remaining part is requested again
+	while(size > 0)
+	{
+		const auto result = pread(m_hFile, data, size, offset);
+
+		if(result < 0 && errno == EINTR) continue;
+		if(result <= 0) return false;
+		offset += result;
+		data += result;
+		size -= result;
+	}
+
+	return true;
+}
+
+bool BlockFile::write(unsigned long long offset, const unsigned char *data, unsigned long long size)
+{
+	while(size > 0)
+	{
+		const auto result = pwrite(m_hFile, data, size, offset);
+
+		if(result < 0 && errno == EINTR) continue;
+		if(result <= 0) return false;
+		offset += result;
+		data += result;
+		size -= result;
+	}
+
+	return true;
+}
+
+bool BlockFile::sync(bool dataOnly)
+{
+	return ((dataOnly ? fdatasync(m_hFile) : fsync(m_hFile)) == 0);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+// File served by the block server, accessed with synchronous positional I/O so all the connections share it
+class BlockFile
+{
+public:
+	BlockFile();
+	~BlockFile();
+
+	bool open(const std::string &fileName, bool dataSync);
+	void close();
+	bool isOpen() const;
+	bool read(unsigned long long offset, unsigned char *data, unsigned long long size);
+	bool write(unsigned long long offset, const unsigned char *data, unsigned long long size);
+	bool sync(bool dataOnly);
+
+private:
+	int m_hFile;
+};
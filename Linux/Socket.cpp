@@ -0,0 +1,256 @@
+#include <errno.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "Socket.h"
+
+using namespace std;
+
+Socket::Socket() : m_socket(-1)
+{
+}
+
+Socket::Socket(Socket &&other) : m_socket(other.m_socket)
+{
+	other.m_socket = -1;
+}
+
+Socket::~Socket()
+{
+	close();
+}
+
+Socket& Socket::operator=(Socket &&other)
+{
+	if(this != &other)
+	{
+		close();
+		m_socket = other.m_socket;
+		other.m_socket = -1;
+	}
+	return *this;
+}
+
+bool Socket::listen(const string &address, unsigned short port)
+{
+	const int reuse = 1;
+	addrinfo hints, *addresses;
+
+	close();
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_PASSIVE;
+	if(getaddrinfo(address.c_str(), to_string(port).c_str(), &hints, &addresses) != 0)
+	{
+		cerr << "Unable to resolve address " << address << endl;
+		return false;
+	}
+	for(auto bindAddress = addresses; bindAddress != nullptr && m_socket == -1; bindAddress = bindAddress->ai_next)
+	{
+		m_socket = socket(bindAddress->ai_family, bindAddress->ai_socktype, bindAddress->ai_protocol);
+		if(m_socket == -1) continue;
+		setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+		if(bind(m_socket, bindAddress->ai_addr, bindAddress->ai_addrlen) == -1 || ::listen(m_socket, SOMAXCONN) == -1) close();
+	}
+	freeaddrinfo(addresses);
+	if(m_socket == -1)
+	{
+		cerr << "Unable to listen on " << address << ":" << port << endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool Socket::accept(Socket &client)
+{
+	const int noDelay = 1;
+	int clientSocket;
+
+	clientSocket = ::accept(m_socket, nullptr, nullptr);
+	if(clientSocket == -1)
+	{
+		return false;
+	}
+	setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+	client.close();
+	client.m_socket = clientSocket;
+
+	return true;
+}
+
+bool Socket::connect(const string &host, unsigned short port)
+{
+	const int noDelay = 1;
+	addrinfo hints, *addresses;
+
+	close();
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	if(getaddrinfo(host.c_str(), to_string(port).c_str(), &hints, &addresses) != 0)
+	{
+		cerr << "Unable to resolve host " << host << endl;
+		return false;
+	}
+	for(auto address = addresses; address != nullptr && m_socket == -1; address = address->ai_next)
+	{
+		m_socket = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+		if(m_socket != -1 && ::connect(m_socket, address->ai_addr, address->ai_addrlen) == -1) close();
+	}
+	freeaddrinfo(addresses);
+	if(m_socket == -1)
+	{
+		cerr << "Unable to connect to " << host << ":" << port << endl;
+		return false;
+	}
+	setsockopt(m_socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+	return true;
+}
+
+void Socket::close()
+{
+	if(m_socket != -1)
+	{
+		::close(m_socket);
+		m_socket = -1;
+	}
+}
+
+bool Socket::isOpen() const
+{
+	return (m_socket != -1);
+}
+
+bool Socket::waitReadable(unsigned int msTimeout)
+{
+	pollfd pollData;
+
+	pollData.fd = m_socket;
+	pollData.events = POLLIN;
+	pollData.revents = 0;
+
+	return (poll(&pollData, 1, static_cast<int>(msTimeout)) > 0);
+}
+
+bool Socket::wait(bool &readable, bool &writable)
+{
+	pollfd pollData;
+
+	pollData.fd = m_socket;
+	pollData.events = (POLLIN | POLLOUT);
+	pollData.revents = 0;
+	if(poll(&pollData, 1, -1) <= 0 || (pollData.revents & (POLLERR | POLLNVAL)) != 0)
+	{
+		return false;
+	}
+	readable = ((pollData.revents & (POLLIN | POLLHUP)) != 0);
+	writable = ((pollData.revents & POLLOUT) != 0);
+
+	return true;
+}
+
+string Socket::getPeerName() const
+{
+	sockaddr_storage address;
+	socklen_t addressSize = sizeof(address);
+	char host[NI_MAXHOST], port[NI_MAXSERV];
+
+	if(getpeername(m_socket, reinterpret_cast<sockaddr*>(&address), &addressSize) == -1
+	|| getnameinfo(reinterpret_cast<sockaddr*>(&address), addressSize, host, sizeof(host), port, sizeof(port), NI_NUMERICHOST | NI_NUMERICSERV) != 0)
+	{
+		return string();
+	}
+
+	return string(host) + ":" + port;
+}
+
+bool Socket::send(const void *data, size_t size)
+{
+	auto buffer = static_cast<const char*>(data);
+
+	while(size > 0)
+	{
+		const auto sent = ::send(m_socket, buffer, size, MSG_NOSIGNAL);
+
+		if(sent <= 0) return false;
+		buffer += sent;
+		size -= sent;
+	}
+
+	return true;
+}
+
+bool Socket::sendAvailable(const void *data, size_t size, size_t &sentSize)
+{
+	// Sends only what fits the socket buffer without waiting
+	const auto sent = ::send(m_socket, data, size, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+	if(sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+	{
+		sentSize = 0;
+		return true;
+	}
+	if(sent <= 0) return false;
+	sentSize = static_cast<size_t>(sent);
+
+	return true;
+}
+
+bool Socket::receive(void *data, size_t size)
+{
+	auto buffer = static_cast<char*>(data);
+
+	while(size > 0)
+	{
+		const auto received = ::recv(m_socket, buffer, size, 0);
+
+		if(received <= 0) return false;
+		buffer += received;
+		size -= received;
+	}
+
+	return true;
+}
+
+bool Socket::sendMessage(const string &message)
+{
+	const uint32_t size = htonl(static_cast<uint32_t>(message.size()));
+
+	if(message.size() > MaxMessageSize)
+	{
+		cerr << "Message of " << message.size() << " bytes over the limit" << endl;
+		return false;
+	}
+
+	// Every message is preceded by its size in network byte order
+	return (send(&size, sizeof(size)) && send(message.data(), message.size()));
+}
+
+bool Socket::receiveMessage(string &message)
+{
+	uint32_t size;
+
+	if(receive(&size, sizeof(size)) == false)
+	{
+		return false;
+	}
+
+	// Size comes from the peer, a message over the limit closes the connection instead of allocating it
+	if(ntohl(size) > MaxMessageSize)
+	{
+		cerr << "Message of " << ntohl(size) << " bytes from " << getPeerName() << " over the limit" << endl;
+		close();
+		return false;
+	}
+	message.resize(ntohl(size));
+
+	return receive(&message[0], message.size());
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <iostream>
+
+class Socket
+{
+public:
+	Socket();
+	Socket(Socket &&other);
+	~Socket();
+
+	static constexpr size_t MaxMessageSize = (64 * 1024 * 1024);
+
+	Socket& operator=(Socket &&other);
+
+	bool listen(const std::string &address, unsigned short port);
+	bool accept(Socket &client);
+	bool connect(const std::string &host, unsigned short port);
+	void close();
+	bool isOpen() const;
+	bool waitReadable(unsigned int msTimeout);
+	bool wait(bool &readable, bool &writable);
+	std::string getPeerName() const;
+
+	bool send(const void *data, size_t size);
+	bool sendAvailable(const void *data, size_t size, size_t &sentSize);
+	bool receive(void *data, size_t size);
+	bool sendMessage(const std::string &message);
+	bool receiveMessage(std::string &message);
+
+private:
+	int m_socket;
+
+	Socket(const Socket&) = delete;
+	Socket& operator=(const Socket&) = delete;
+};
@@ -1,154 +1,341 @@
-#include <vector>
-#include <unistd.h>
-#include <string.h>
-#include <fcntl.h>
-#include <sys/stat.h>
-#include "SystemFile.h"
-
-using namespace std;
-
-SystemFile::SystemFile(exception_ptr &exception) : m_hFile(-1),
-												   m_logMsgFunction([](const string &logMsg) {})
-{
-}
-
-SystemFile::~SystemFile()
-{
-}
-
-void SystemFile::setLogMsgFunction(const LogMsgFunction &logMsgFunction)
-{
-	m_logMsgFunction = logMsgFunction;
-}
-
-bool SystemFile::initialize(const string &fileName, bool directAccess, unsigned long long fileSize, unsigned char *block, unsigned long long blockSize, bool useExisting)
-{
-	const auto blockNumber = (fileSize / blockSize);
-	struct stat fileStat;
-
-	close(!useExisting);
-
-	if(useExisting == false
-	|| stat(fileName.c_str(), &fileStat) < 0
-	|| fileStat.st_size != fileSize)
-	{
-		int hFile = open(fileName.c_str(), O_CREAT | O_WRONLY | O_TRUNC, S_IWUSR | S_IRUSR);
-		if(hFile == -1)
-		{
-			cerr << "Unable to create file " << fileName << endl;
-			return false;
-		}
-		for(unsigned long long i = 0; i < blockNumber; i++)
-		{
-			if(write(hFile, block, blockSize) != blockSize)
-			{
-				cerr << "Unable to write inside file " << fileName << endl;
-				return false;
-			}
-		}
-		fsync(hFile);
-		::close(hFile);
-		m_logMsgFunction("New test file '" + fileName + "' created");
-	}
-
-	m_fileFlags = O_RDWR;
-	if(directAccess) m_fileFlags |= O_DIRECT;
-	m_hFile = open(fileName.c_str(), m_fileFlags);
-	if(m_hFile == -1)
-	{
-		cerr << "Unable to open file " << fileName << endl;
-		return false;
-	}
-
-	m_fileName = fileName;
-
-	return true;
-}
-
-void SystemFile::close(bool removeFile)
-{
-	if(m_hFile != -1)
-	{
-		::close(m_hFile);
-		if(removeFile) remove(m_fileName.c_str());
-		m_fileName.clear();
-		m_hFile = -1;
-	}
-}
-
-SystemFile::FileHandle SystemFile::openFile(unsigned int taskNumber)
-{
-	FileHandle file;
-
-	file.handle = open(m_fileName.c_str(), m_fileFlags);
-	if(file.handle == -1)
-	{
-		throw runtime_error(string("open() return error ") + strerror(errno));
-	}
-	memset(&file.context, 0, sizeof(file.context));
-	if(io_setup(taskNumber, &file.context) != 0)
-	{
-		throw runtime_error("io_setup() error");
-	}
-
-	return file;
-}
-
-void SystemFile::closeFile(FileHandle file)
-{
-	io_destroy(file.context);
-	::close(file.handle);
-}
-
-void SystemFile::writeBlock(FileHandle file, unsigned long long offset, unsigned char *data, unsigned long long size, BlockHandle *block)
-{
-	io_prep_pwrite(block, file.handle, data, size, offset);
-	if(io_submit(file.context, 1, &block) != 1)
-	{
-		throw runtime_error("io_submit() error");
-	}
-}
-
-void SystemFile::readBlock(FileHandle file, unsigned long long offset, unsigned char *data, unsigned long long size, BlockHandle *block)
-{
-	io_prep_pread(block, file.handle, data, size, offset);
-	if(io_submit(file.context, 1, &block) != 1)
-	{
-		throw runtime_error("io_submit() error");
-	}
-}
-
-SystemFile::BlockHandle* SystemFile::getCompletedBlock(FileHandle file)
-{
-	io_event event;
-
-	memset(&event, 0, sizeof(event));
-	io_getevents(file.context, 0, 1, &event, NULL);
-	if(event.obj != NULL);
-	{
-		if(event.res < 0)
-		{
-			throw runtime_error("io_getevents() event error");
-		}
-		return event.obj;
-	}
-
-	return nullptr;
-}
-
-unsigned char* SystemFile::allocateAlignedMemory(unsigned long long size)
-{
-	void *ptr = nullptr;
-	posix_memalign(&ptr, getMemoryPageSize(), size);
-	return reinterpret_cast<unsigned char*>(ptr);
-}
-
-void SystemFile::freeAlignedMemory(unsigned char *ptr)
-{
-	free(ptr);
-}
-
-unsigned int SystemFile::getMemoryPageSize()
-{
-	return sysconf(_SC_PAGESIZE);
+#include <fstream>
+#include <vector>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#include <linux/falloc.h>
+#include "SystemFile.h"
+
+using namespace std;
+
+SystemFile::SystemFile(exception_ptr &exception) : m_hFile(-1),
+												   m_fileSize(0),
+												   m_blockAlignment(0),
+												   m_blockDevice(false),
+												   m_logMsgFunction([](const string &logMsg) {})
+{
+}
+
+SystemFile::~SystemFile()
+{
+}
+
+void SystemFile::setLogMsgFunction(const LogMsgFunction &logMsgFunction)
+{
+	m_logMsgFunction = logMsgFunction;
+}
+
+bool SystemFile::initialize(const string &fileName, bool directAccess, bool dataSync, unsigned long long fileSize, unsigned char *block, unsigned long long blockSize, bool useExisting)
+{
+	struct stat fileStat;
+
+	close(!useExisting);
+
+	// Block devices are used as they are, without any creation or prefill
+	m_blockDevice = (stat(fileName.c_str(), &fileStat) == 0 && S_ISBLK(fileStat.st_mode));
+	if(m_blockDevice == false
+	&& (useExisting == false || stat(fileName.c_str(), &fileStat) < 0 || fileStat.st_size != fileSize))
+	{
+		const auto blockNumber = (fileSize / blockSize);
+		int hFile;
+
+		if(blockNumber == 0)
+		{
+			cerr << "Invalid size for file " << fileName << endl;
+			return false;
+		}
+		hFile = open(fileName.c_str(), O_CREAT | O_WRONLY | O_TRUNC, S_IWUSR | S_IRUSR);
+		if(hFile == -1)
+		{
+			cerr << "Unable to create file " << fileName << endl;
+			return false;
+		}
+		for(unsigned long long i = 0; i < blockNumber; i++)
+		{
+			if(write(hFile, block, blockSize) != blockSize)
+			{
+				cerr << "Unable to write inside file " << fileName << endl;
+				return false;
+			}
+		}
+		fsync(hFile);
+		::close(hFile);
+		m_logMsgFunction("New test file '" + fileName + "' created");
+	}
+
+	m_fileFlags = O_RDWR;
+	if(directAccess) m_fileFlags |= O_DIRECT;
+	if(dataSync) m_fileFlags |= O_DSYNC;
+	m_hFile = open(fileName.c_str(), m_fileFlags);
+	if(m_hFile == -1)
+	{
+		cerr << "Unable to open file " << fileName << endl;
+		return false;
+	}
+
+	m_fileName = fileName;
+	m_fileSize = fileSize;
+	m_blockAlignment = getMemoryPageSize();
+	if(m_blockDevice)
+	{
+		unsigned long long deviceSize = 0;
+		unsigned int physicalBlockSize = 0;
+		int logicalBlockSize = 0;
+
+		if(ioctl(m_hFile, BLKGETSIZE64, &deviceSize) != 0 || ioctl(m_hFile, BLKSSZGET, &logicalBlockSize) != 0)
+		{
+			cerr << "Unable to get geometry of block device " << fileName << endl;
+			close(false);
+			return false;
+		}
+		if(ioctl(m_hFile, BLKPBSZGET, &physicalBlockSize) != 0) physicalBlockSize = logicalBlockSize;
+		if(fileSize == 0 || fileSize > deviceSize) m_fileSize = deviceSize;
+		m_blockAlignment = logicalBlockSize;
+		m_logMsgFunction("Block device '" + fileName + "' size " + to_string(deviceSize) + " bytes, logical block " + to_string(logicalBlockSize) + " bytes, physical block " + to_string(physicalBlockSize) + " bytes");
+	}
+#ifdef STATX_DIOALIGN
+	if(directAccess)
+	{
+		struct statx fileStatx;
+
+		if(statx(m_hFile, "", AT_EMPTY_PATH, STATX_DIOALIGN, &fileStatx) == 0 && (fileStatx.stx_mask & STATX_DIOALIGN) && fileStatx.stx_dio_offset_align > 0)
+		{
+			m_blockAlignment = max(fileStatx.stx_dio_offset_align, fileStatx.stx_dio_mem_align);
+		}
+	}
+#endif
+
+	return true;
+}
+
+void SystemFile::close(bool removeFile)
+{
+	if(m_hFile != -1)
+	{
+		::close(m_hFile);
+		if(removeFile && m_blockDevice == false) remove(m_fileName.c_str());
+		m_fileName.clear();
+		m_hFile = -1;
+	}
+}
+
+SystemFile::FileHandle SystemFile::openFile(unsigned int taskNumber)
+{
+	FileHandle file;
+
+	file.handle = open(m_fileName.c_str(), m_fileFlags);
+	if(file.handle == -1)
+	{
+		throw runtime_error(string("open() return error ") + strerror(errno));
+	}
+	memset(&file.context, 0, sizeof(file.context));
+	if(io_setup(taskNumber, &file.context) != 0)
+	{
+		throw runtime_error("io_setup() error");
+	}
+	file.engineData = new DiscardWorker;
+
+	return file;
+}
+
+void SystemFile::closeFile(FileHandle file)
+{
+	auto worker = reinterpret_cast<DiscardWorker*>(file.engineData);
+
+	if(worker->thread.joinable())
+	{
+		{
+			lock_guard<mutex> lock(worker->mutex);
+
+			worker->stop = true;
+		}
+		worker->condition.notify_one();
+		worker->thread.join();
+	}
+	delete worker;
+	io_destroy(file.context);
+	::close(file.handle);
+}
+
+void SystemFile::writeBlock(FileHandle file, unsigned long long offset, unsigned char *data, unsigned long long size, BlockHandle *block)
+{
+	io_prep_pwrite(block, file.handle, data, size, offset);
+	if(io_submit(file.context, 1, &block) != 1)
+	{
+		throw runtime_error("io_submit() error");
+	}
+}
+
+void SystemFile::readBlock(FileHandle file, unsigned long long offset, unsigned char *data, unsigned long long size, BlockHandle *block)
+{
+	io_prep_pread(block, file.handle, data, size, offset);
+	if(io_submit(file.context, 1, &block) != 1)
+	{
+		throw runtime_error("io_submit() error");
+	}
+}
+
+bool SystemFile::syncFile(FileHandle file, bool dataOnly, BlockHandle *block)
+{
+	int result;
+
+	if(dataOnly)
+		io_prep_fdsync(block, file.handle);
+	else
+		io_prep_fsync(block, file.handle);
+	result = io_submit(file.context, 1, &block);
+	if(result == 1)
+	{
+		return true;
+	}
+	if(result != -EINVAL)
+	{
+		throw runtime_error("io_submit() error");
+	}
+
+	// Kernel without asynchronous fsync support, sync is executed immediately
+	if((dataOnly ? fdatasync(file.handle) : fsync(file.handle)) != 0)
+	{
+		throw runtime_error(string("fsync() return error ") + strerror(errno));
+	}
+
+	return false;
+}
+
+bool SystemFile::discardBlock(FileHandle file, unsigned long long offset, unsigned long long size, BlockHandle *block)
+{
+	auto worker = reinterpret_cast<DiscardWorker*>(file.engineData);
+
+	// Linux AIO doesn't support discard, a helper thread of the file handle executes them and its completions
+	// are returned by getCompletedBlock, so the test thread keeps reaping the other I/O meanwhile
+	if(!worker->thread.joinable())
+	{
+		worker->thread = thread(&SystemFile::executeDiscards, this, file.handle, worker);
+	}
+	{
+		lock_guard<mutex> lock(worker->mutex);
+
+		worker->requests.push_back({offset, size, block, string()});
+	}
+	worker->condition.notify_one();
+
+	return true;
+}
+
+SystemFile::BlockHandle* SystemFile::getCompletedBlock(FileHandle file)
+{
+	auto worker = reinterpret_cast<DiscardWorker*>(file.engineData);
+	io_event event;
+
+	{
+		lock_guard<mutex> lock(worker->mutex);
+
+		if(!worker->completedRequests.empty())
+		{
+			const auto request = worker->completedRequests.front();
+
+			worker->completedRequests.pop_front();
+			if(!request.error.empty()) throw runtime_error(request.error);
+			return request.block;
+		}
+	}
+
+	memset(&event, 0, sizeof(event));
+	io_getevents(file.context, 0, 1, &event, NULL);
+	if(event.obj != NULL);
+	{
+		if(event.res < 0)
+		{
+			throw runtime_error("io_getevents() event error");
+		}
+		return event.obj;
+	}
+
+	return nullptr;
+}
+
+unsigned char* SystemFile::allocateAlignedMemory(unsigned long long size)
+{
+	void *ptr = nullptr;
+	posix_memalign(&ptr, getMemoryPageSize(), size);
+	return reinterpret_cast<unsigned char*>(ptr);
+}
+
+void SystemFile::freeAlignedMemory(unsigned char *ptr)
+{
+	free(ptr);
+}
+
+unsigned int SystemFile::getMemoryPageSize()
+{
+	return sysconf(_SC_PAGESIZE);
+}
+
+unsigned long long SystemFile::getFileSize()
+{
+	return m_fileSize;
+}
+
+unsigned int SystemFile::getBlockAlignment()
+{
+	return m_blockAlignment;
+}
+
+bool SystemFile::isBlockDevice()
+{
+	return m_blockDevice;
+}
+
+bool SystemFile::dropCaches()
+{
+	ofstream dropCachesFile("/proc/sys/vm/drop_caches");
+
+	// Dirty pages are written first, only clean pages can be dropped
+	sync();
+	if(!dropCachesFile.is_open() || !(dropCachesFile << "3" << endl))
+	{
+		cerr << "Unable to drop the page cache (root privileges needed)" << endl;
+		return false;
+	}
+
+	return true;
+}
+
+void SystemFile::executeDiscards(int handle, DiscardWorker *worker)
+{
+	unique_lock<mutex> lock(worker->mutex);
+
+	while(true)
+	{
+		worker->condition.wait(lock, [worker] { return worker->stop || !worker->requests.empty(); });
+		if(worker->requests.empty()) break;
+
+		auto request = worker->requests.front();
+
+		worker->requests.pop_front();
+		lock.unlock();
+		request.error = discardRange(handle, request.offset, request.size);
+		lock.lock();
+		worker->completedRequests.push_back(request);
+	}
+}
+
+string SystemFile::discardRange(int handle, unsigned long long offset, unsigned long long size)
+{
+	// blocks are released by discard on devices and by hole punching on files
+	if(m_blockDevice)
+	{
+		unsigned long long range[2] = {offset, size};
+
+		if(ioctl(handle, BLKDISCARD, &range) != 0) return string("ioctl(BLKDISCARD) return error ") + strerror(errno);
+	}
+	else
+	{
+		if(fallocate(handle, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, size) != 0) return string("fallocate() return error ") + strerror(errno);
+	}
+
+	return string();
 }
\ No newline at end of file
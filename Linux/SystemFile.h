@@ -1,42 +1,76 @@
-#pragma once
-
-#include <map>
-#include <functional>
-#include <iostream>
-#include "libaio.h"
-
-class SystemFile
-{
-public:
-	SystemFile(std::exception_ptr &exception);
-	~SystemFile();
-
-	using LogMsgFunction = std::function<void(const std::string &logMsg)>;
-
-	struct FileHandle
-	{
-		int handle;
-		io_context_t context;
-	};
-	using BlockHandle = iocb;
-
-	void setLogMsgFunction(const LogMsgFunction &logMsgFunction);
-
-	bool initialize(const std::string &fileName, bool directAccess, unsigned long long fileSize, unsigned char *block, unsigned long long blockSize, bool useExisting = false);
-	void close(bool removeFile = true);
-
-	FileHandle openFile(unsigned int taskNumber);
-	void closeFile(FileHandle file);
-	void writeBlock(FileHandle file, unsigned long long offset, unsigned char *data, unsigned long long size, BlockHandle *block);
-	void readBlock(FileHandle file, unsigned long long offset, unsigned char *data, unsigned long long size, BlockHandle *block);
-	BlockHandle* getCompletedBlock(FileHandle file);
-	unsigned char* allocateAlignedMemory(unsigned long long size);
-	void freeAlignedMemory(unsigned char *ptr);
-	unsigned int getMemoryPageSize();
-
-private:
-	int m_hFile;
-	int m_fileFlags;
-	std::string m_fileName;
-	LogMsgFunction m_logMsgFunction;
+#pragma once
+
+#include <map>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include "libaio.h"
+
+class SystemFile
+{
+public:
+	SystemFile(std::exception_ptr &exception);
+	virtual ~SystemFile();
+
+	using LogMsgFunction = std::function<void(const std::string &logMsg)>;
+
+	struct FileHandle
+	{
+		int handle;
+		io_context_t context;
+		void *engineData = nullptr;
+	};
+	using BlockHandle = iocb;
+
+	void setLogMsgFunction(const LogMsgFunction &logMsgFunction);
+
+	virtual bool initialize(const std::string &fileName, bool directAccess, bool dataSync, unsigned long long fileSize, unsigned char *block, unsigned long long blockSize, bool useExisting = false);
+	virtual void close(bool removeFile = true);
+
+	virtual FileHandle openFile(unsigned int taskNumber);
+	virtual void closeFile(FileHandle file);
+	virtual void writeBlock(FileHandle file, unsigned long long offset, unsigned char *data, unsigned long long size, BlockHandle *block);
+	virtual void readBlock(FileHandle file, unsigned long long offset, unsigned char *data, unsigned long long size, BlockHandle *block);
+	virtual bool syncFile(FileHandle file, bool dataOnly, BlockHandle *block);
+	virtual bool discardBlock(FileHandle file, unsigned long long offset, unsigned long long size, BlockHandle *block);
+	virtual BlockHandle* getCompletedBlock(FileHandle file);
+	unsigned char* allocateAlignedMemory(unsigned long long size);
+	void freeAlignedMemory(unsigned char *ptr);
+	unsigned int getMemoryPageSize();
+	virtual unsigned long long getFileSize();
+	virtual unsigned int getBlockAlignment();
+	virtual bool isBlockDevice();
+	static bool dropCaches();
+
+private:
+	struct DiscardRequest
+	{
+		unsigned long long offset;
+		unsigned long long size;
+		BlockHandle *block;
+		std::string error;
+	};
+	struct DiscardWorker
+	{
+		std::thread thread;
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::deque<DiscardRequest> requests;
+		std::deque<DiscardRequest> completedRequests;
+		bool stop = false;
+	};
+
+	int m_hFile;
+	int m_fileFlags;
+	std::string m_fileName;
+	unsigned long long m_fileSize;
+	unsigned int m_blockAlignment;
+	bool m_blockDevice;
+	LogMsgFunction m_logMsgFunction;
+
+	void executeDiscards(int handle, DiscardWorker *worker);
+	std::string discardRange(int handle, unsigned long long offset, unsigned long long size);
 };
\ No newline at end of file
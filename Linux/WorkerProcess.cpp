@@ -0,0 +1,86 @@
+#include <cerrno>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "WorkerProcess.h"
+
+using namespace std;
+
+WorkerProcess::WorkerProcess() : m_sharedMemory(nullptr),
+								 m_sharedMemorySize(0),
+								 m_pid(-1),
+								 m_status(0),
+								 m_failed(false)
+{
+}
+
+WorkerProcess::~WorkerProcess()
+{
+	if(m_pid > 0)
+	{
+		kill(m_pid, SIGKILL);
+		wait(true);
+	}
+	if(m_sharedMemory != nullptr) munmap(m_sharedMemory, m_sharedMemorySize);
+}
+
+void* WorkerProcess::allocateSharedMemory(size_t size)
+{
+	// Anonymous shared mapping is inherited by the child and stays shared after the fork
+	m_sharedMemory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if(m_sharedMemory == MAP_FAILED)
+	{
+		cerr << "Unable to allocate shared memory for worker process" << endl;
+		m_sharedMemory = nullptr;
+		return nullptr;
+	}
+	m_sharedMemorySize = size;
+
+	return m_sharedMemory;
+}
+
+bool WorkerProcess::start(const WorkerFunction &function)
+{
+	m_failed = false;
+	m_pid = fork();
+	if(m_pid < 0)
+	{
+		cerr << "Unable to start worker process" << endl;
+		return false;
+	}
+	if(m_pid == 0)
+	{
+		// Child leaves without running destructors or exit handlers of the objects copied from the parent
+		function(m_sharedMemory);
+		_exit(0);
+	}
+
+	return true;
+}
+
+bool WorkerProcess::isRunning()
+{
+	if(m_pid > 0) wait(false);
+
+	return (m_pid > 0);
+}
+
+bool WorkerProcess::exitedNormally() const
+{
+	return (m_pid <= 0 && m_failed == false && WIFEXITED(m_status) && WEXITSTATUS(m_status) == 0);
+}
+
+void WorkerProcess::wait(bool block)
+{
+	pid_t result;
+
+	while((result = waitpid(m_pid, &m_status, block ? 0 : WNOHANG)) < 0 && errno == EINTR);
+	if(result < 0)
+	{
+		// Status of a worker that can't be waited for is unknown, it is not reported as a normal exit
+		cerr << "Unable to wait for worker process" << endl;
+		m_failed = true;
+	}
+	if(result != 0) m_pid = -1;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <functional>
+#include <iostream>
+#include <sys/types.h>
+
+class WorkerProcess
+{
+public:
+	WorkerProcess();
+	~WorkerProcess();
+
+	using WorkerFunction = std::function<void(void *sharedMemory)>;
+
+	void* allocateSharedMemory(size_t size);
+	bool start(const WorkerFunction &function);
+	bool isRunning();
+	bool exitedNormally() const;
+
+private:
+	void *m_sharedMemory;
+	size_t m_sharedMemorySize;
+	pid_t m_pid;
+	int m_status;
+	bool m_failed;
+
+	void wait(bool block);
+};
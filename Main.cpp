@@ -1,111 +1,671 @@
-﻿#include "DiskBenchmark.h"
-#include "CLI11/CLI.hpp"
-
-using namespace std;
-
-int main(int argc, char **argv)
-{
-	const auto calculateMBPerSec = [](unsigned long long totalBytes, unsigned long long msDuration)-> double
-	{
-		return (round(((static_cast<double>(totalBytes) / (1024.0 * 1024.0)) / (static_cast<double>(msDuration) / 1000.0)) * 10.0) / 10.0);
-	};
-	CLI::Option *optSeconds, *optIOType, *optRandom, *optThreadNumber, *optTaskNumber, *optUnalignedOffsets,
-				*optFileName, *optFileSize, *optBlockSize, *optShowLog, *optReadPercentage, *optUseExistingFile;
-	CLI::App app("DiskBenchmark");
-	DiskBenchmark diskBenchmark;
-	int seconds, threadNumber, taskNumber, readPercentage;
-	DiskBenchmark::ThreadInfoList threadInfoList;
-	unsigned long long totalBytesRead, totalBytesWrite, msDuration;
-	long long fileSize, blockSize;
-	DiskBenchmark::IOType ioType;
-	string fileName, ioTypeParam;
-
-	optSeconds = app.add_option("-s,--seconds", seconds, "Duration of test in seconds (optional)");
-	optIOType = app.add_option("-i,--io_type", ioTypeParam, "I/O test type (r -> read, w -> write, rw -> read/write)");
-	optReadPercentage = app.add_option("-p,--read_percentage", readPercentage, "Percentage of read blocks for read/write test");
-	optRandom = app.add_flag("-r,--random", "Random read/write");
-	optThreadNumber = app.add_option("-t,--thread", threadNumber, "Number of thread to use for the test");
-	optTaskNumber = app.add_option("-o,--task", taskNumber, "Number of I/O operation per thread");
-	optUnalignedOffsets = app.add_flag("-u,--unaligned", "Different starting offsets for each thread");
-	optFileName = app.add_option("-n,--file_name", fileName, "Name of the file to use for test");
-	optFileSize = app.add_option("-z,--file_size", fileSize, "Size of the file to use for test (in Mb)");
-	optBlockSize = app.add_option("-b,--block_size", blockSize, "Size of the block to read/write (in Kb)");
-	optUseExistingFile = app.add_flag("-e,--use_existing", "If already exist a test file use it instead of create a new one");
-	optShowLog = app.add_flag("-l,--log", "Show log messages");
-	CLI11_PARSE(app, argc, argv);
-	
-	if(optIOType->count() == 0
-	|| optFileName->count() == 0
-	|| optFileSize->count() == 0 || fileSize == 0
-	|| optBlockSize->count() == 0 || blockSize == 0)
-	{
-		cerr << "Invalid or missing param (use -h for help)" << endl;
-		return 1;
-	}
-	if(ioTypeParam == "r")
-		ioType = DiskBenchmark::IOType::Read;
-	else if(ioTypeParam == "w")
-		ioType = DiskBenchmark::IOType::Write;
-	else if(ioTypeParam == "rw")
-		ioType = DiskBenchmark::IOType::ReadWrite;
-	else
-	{
-		cerr << "Invalid I/O type test param (use -h for help)" << endl;
-		return 1;
-	}
-	if(optShowLog->count() > 0) diskBenchmark.setLogMsgFunction([](const string& logMsg) { cout << logMsg << endl; });
-	if(optThreadNumber->count() == 0) threadNumber = 1;
-	if(optTaskNumber->count() == 0) taskNumber = 1;
-	if(optSeconds->count() > 0 && seconds > 0)
-	{
-		diskBenchmark.setSecondsDuration(seconds);
-	}
-	if(optReadPercentage->count() > 0)
-	{
-		if(readPercentage < 0 || readPercentage > 100)
-		{
-			cerr << "Incorrect read percentage value" << endl;
-			return 1;
-		}
-		diskBenchmark.setReadPercentage(static_cast<unsigned char>(readPercentage));
-	}
-	diskBenchmark.setRandomAccess((optRandom->count() > 0) ? true : false);
-	diskBenchmark.setUnalignedOffsets((optUnalignedOffsets->count() > 0) ? true : false);
-	diskBenchmark.setUseExistingFile((optUseExistingFile->count() > 0) ? true : false);
-	fileSize *= (1024 * 1024);
-	blockSize *= 1024;
-
-	cout << "Start benchmark..." << endl << endl;
-	totalBytesRead = totalBytesWrite = msDuration = 0;
-	threadInfoList = diskBenchmark.executeTest(ioType, threadNumber, taskNumber, fileName, fileSize, blockSize);
-	if(threadInfoList.size() > 0)
-	{
-		int threadCount = 1;
-
-		for(const auto &threadInfo : threadInfoList)
-		{
-			cout << "Thread " << threadCount++ << endl;
-			if(threadInfo.totalReadOperations == 0 && threadInfo.totalWriteOperations == 0)
-			{
-				cerr << "  Thread error occurred" << endl;
-				continue;
-			}
-			if(threadInfo.totalReadOperations > 0)
-			{
-				cout << "  Read ops: " << threadInfo.totalReadOperations << " (" << ((threadInfo.totalReadOperations * blockSize) / 1024) << "KB)" << endl;
-				totalBytesRead += (threadInfo.totalReadOperations * blockSize);
-			}
-			if(threadInfo.totalWriteOperations > 0)
-			{
-				cout << "  Write ops: " << threadInfo.totalWriteOperations << " (" << ((threadInfo.totalWriteOperations * blockSize) / 1024) << "KB)" << endl;
-				totalBytesWrite += (threadInfo.totalWriteOperations * blockSize);
-			}
-			if(threadInfo.msDuration > msDuration) msDuration = threadInfo.msDuration;
-		}
-	}
-	cout << endl << "Total test duration (ms): " << msDuration << endl;
-	if(totalBytesRead > 0) cout << "Read MB/s " << fixed << setprecision(1) << calculateMBPerSec(totalBytesRead, msDuration) << endl;
-	if(totalBytesWrite > 0) cout << "Write MB/s " << fixed << setprecision(1) << calculateMBPerSec(totalBytesWrite, msDuration) << endl;
-
-	return 0;
-}
+﻿#include "DiskBenchmark.h"
+#include "JobFile.h"
+#include "Baseline.h"
+#include "ClusterAgent.h"
+#include "ClusterController.h"
+#include "CLI11/CLI.hpp"
+#include <csignal>
+#include <filesystem>
+
+using namespace std;
+
+static DiskBenchmark *interruptedBenchmark = nullptr;
+static volatile sig_atomic_t interrupted = 0;
+
+// First Ctrl+C stops the running test and prints the results collected until now, a second one terminates the program
+static void interruptHandler(int)
+{
+	interrupted = 1;
+	if(interruptedBenchmark != nullptr) interruptedBenchmark->stop();
+	signal(SIGINT, SIG_DFL);
+}
+
+int main(int argc, char **argv)
+{
+	struct Summary
+	{
+		string name;
+		unsigned int run;
+		DiskBenchmark::JobSummary job;
+	};
+	const auto calculateMBPerSec = [](unsigned long long totalBytes, unsigned long long msDuration)-> double
+	{
+		return (round(((static_cast<double>(totalBytes) / (1024.0 * 1024.0)) / (static_cast<double>(msDuration) / 1000.0)) * 10.0) / 10.0);
+	};
+	const auto calculateIOPS = [](unsigned long long totalOperations, unsigned long long msDuration)-> unsigned long long
+	{
+		return (msDuration > 0) ? ((totalOperations * 1000) / msDuration) : 0;
+	};
+	const auto printLatency = [](const string &name, const LatencyHistogram &latency)
+	{
+		const auto us = [](double nsValue) { return (nsValue / 1000.0); };
+
+		cout << name << " latency (us) min " << fixed << setprecision(1) << us(latency.min())
+			 << ", avg " << us(latency.mean())
+			 << ", p50 " << us(latency.percentile(50.0))
+			 << ", p90 " << us(latency.percentile(90.0))
+			 << ", p99 " << us(latency.percentile(99.0))
+			 << ", p99.9 " << us(latency.percentile(99.9))
+			 << ", max " << us(latency.max()) << endl;
+	};
+	const auto printJobInfo = [&](const DiskBenchmark::JobInfo &jobInfo)-> DiskBenchmark::JobSummary
+	{
+		const auto summary = DiskBenchmark::summarizeJob(jobInfo);
+		const auto blockSize = jobInfo.blockSize;
+		DiskBenchmark::VerifyErrorList verifyErrors;
+		DiskBenchmark::TargetInfoList targetInfoList;
+		int threadCount = 1;
+
+		for(const auto &threadInfo : jobInfo.threadInfoList)
+		{
+			cout << "Thread " << threadCount++ << endl;
+			if(threadInfo.regionSize > 0)
+			{
+				cout << "  Region: " << (threadInfo.regionOffset / 1024) << "KB - " << ((threadInfo.regionOffset + threadInfo.regionSize) / 1024) << "KB" << endl;
+			}
+			if(threadInfo.totalReadOperations == 0 && threadInfo.totalWriteOperations == 0 && threadInfo.totalDiscardOperations == 0)
+			{
+				cerr << "  Thread error occurred" << endl;
+				continue;
+			}
+			if(threadInfo.totalReadOperations > 0)
+			{
+				cout << "  Read ops: " << threadInfo.totalReadOperations << " (" << ((threadInfo.totalReadOperations * blockSize) / 1024) << "KB)" << endl;
+			}
+			if(threadInfo.totalWriteOperations > 0)
+			{
+				cout << "  Write ops: " << threadInfo.totalWriteOperations << " (" << ((threadInfo.totalWriteOperations * blockSize) / 1024) << "KB)" << endl;
+			}
+			if(threadInfo.totalSyncOperations > 0)
+			{
+				cout << "  Sync ops: " << threadInfo.totalSyncOperations << endl;
+			}
+			if(threadInfo.totalVerifiedBlocks > 0)
+			{
+				cout << "  Verified blocks: " << threadInfo.totalVerifiedBlocks << endl;
+				verifyErrors.insert(verifyErrors.end(), threadInfo.verifyErrors.begin(), threadInfo.verifyErrors.end());
+			}
+			if(threadInfo.totalDiscardOperations > 0)
+			{
+				cout << "  Discard ops: " << threadInfo.totalDiscardOperations << " (" << ((threadInfo.totalDiscardOperations * blockSize) / 1024) << "KB)" << endl;
+			}
+			if(threadInfo.totalCommits > 0)
+			{
+				cout << "  Commits: " << threadInfo.totalCommits << endl;
+			}
+			cout << "  IOPS: " << calculateIOPS(threadInfo.totalReadOperations + threadInfo.totalWriteOperations + threadInfo.totalDiscardOperations, threadInfo.msDuration) << endl;
+			for(const auto &threadTargetInfo : threadInfo.targetInfoList)
+			{
+				auto targetInfo = find_if(targetInfoList.begin(), targetInfoList.end(), [&](const DiskBenchmark::TargetInfo &info) { return (info.fileName == threadTargetInfo.fileName); });
+
+				if(targetInfo == targetInfoList.end())
+				{
+					targetInfoList.push_back(threadTargetInfo);
+					continue;
+				}
+				targetInfo->totalReadOperations += threadTargetInfo.totalReadOperations;
+				targetInfo->totalWriteOperations += threadTargetInfo.totalWriteOperations;
+				targetInfo->readLatency.merge(threadTargetInfo.readLatency);
+				targetInfo->writeLatency.merge(threadTargetInfo.writeLatency);
+			}
+		}
+		cout << endl;
+		if(summary.msRampDuration > 0) cout << "Ramp duration excluded from results (ms): " << summary.msRampDuration << endl;
+		cout << "Total test duration (ms): " << summary.msDuration << endl;
+		if(summary.totalReadOperations > 0) cout << "Read MB/s " << fixed << setprecision(1) << summary.readMBPerSec << endl;
+		if(summary.totalWriteOperations > 0) cout << "Write MB/s " << fixed << setprecision(1) << summary.writeMBPerSec << endl;
+		if(summary.iops > 0) cout << "IOPS " << summary.iops << endl;
+		if(summary.totalCommits > 0) cout << "Commits/s " << summary.commitsPerSec << endl;
+		if(summary.readLatency.count() > 0) printLatency("Read", summary.readLatency);
+		if(summary.writeLatency.count() > 0) printLatency("Write", summary.writeLatency);
+		if(summary.syncLatency.count() > 0) printLatency("Sync", summary.syncLatency);
+		if(summary.discardLatency.count() > 0) printLatency("Discard", summary.discardLatency);
+		if(summary.commitLatency.count() > 0) printLatency("Commit", summary.commitLatency);
+		if(summary.totalVerifiedBlocks > 0)
+		{
+			const char *errorTypes[] = {"torn", "misplaced", "stale", "lost"};
+
+			cout << "Verified blocks " << summary.totalVerifiedBlocks << ", errors " << summary.totalVerifyErrors << endl;
+			for(const auto &error : verifyErrors)
+			{
+				cerr << "  " << errorTypes[static_cast<int>(error.type)] << " block at offset " << error.offset << " of " << error.fileName
+					 << " (expected generation " << error.expectedGeneration;
+				if(error.type == DiskBenchmark::VerifyErrorType::Lost)
+					cerr << ", no header found)" << endl;
+				else
+					cerr << ", found " << error.foundGeneration << ")" << endl;
+			}
+			if(verifyErrors.size() < summary.totalVerifyErrors) cerr << "  ..." << endl;
+		}
+		for(const auto &targetInfo : targetInfoList)
+		{
+			cout << "Target " << targetInfo.fileName << endl;
+			if(targetInfo.totalReadOperations > 0) cout << "  Read MB/s " << fixed << setprecision(1) << calculateMBPerSec(targetInfo.totalReadOperations * blockSize, summary.msDuration) << endl;
+			if(targetInfo.totalWriteOperations > 0) cout << "  Write MB/s " << fixed << setprecision(1) << calculateMBPerSec(targetInfo.totalWriteOperations * blockSize, summary.msDuration) << endl;
+			cout << "  IOPS " << calculateIOPS(targetInfo.totalReadOperations + targetInfo.totalWriteOperations, summary.msDuration) << endl;
+			if(targetInfo.readLatency.count() > 0) printLatency("  Read", targetInfo.readLatency);
+			if(targetInfo.writeLatency.count() > 0) printLatency("  Write", targetInfo.writeLatency);
+		}
+
+		return summary;
+	};
+	CLI::Option *optSeconds, *optRamp, *optSteadyState, *optSteadyWindow, *optSteadyRange, *optSteadySlope, *optPrecondition, *optPreconditionSeconds, *optIOType, *optRandom, *optThreadNumber, *optTaskNumber, *optUnalignedOffsets,
+				*optFileName, *optFileSize, *optBlockSize, *optShowLog, *optReadPercentage, *optDiscardPercentage, *optCompressRatio, *optDedupePercentage, *optUseExistingFile, *optVerify, *optJournal, *optCheckJournal, *optTrace, *optHeatmap, *optHeatmapInterval, *optEngine, *optNetDepth,
+				*optSync, *optSyncWrites, *optSyncMs, *optDataSync, *optGroupCommit, *optRate, *optAllowDeviceWrite, *optProcesses, *optTargetMode, *optStripeSize, *optQueueMode, *optRegions, *optJobs, *optJobFile, *optAgent, *optBind, *optAgentAllowFiles, *optAgentDir, *optController,
+				*optBaseline, *optSaveBaseline, *optTolerance, *optLatencyTolerance, *optRepeat, *optDropCaches;
+	CLI::App app("DiskBenchmark");
+	DiskBenchmark diskBenchmark;
+	int seconds, agentPort, heatmapInterval, discardPercentage, dedupePercentage, rampSeconds, steadyState, steadyWindow, steadyRange, steadySlope, preconditionPasses, preconditionSeconds, threadNumber, taskNumber, readPercentage, syncWrites, syncMs, groupCommit, rate, netDepth;
+	DiskBenchmark::Job defaultJob;
+	JobFile::Test defaultTest;
+	JobFile::TestList tests;
+	vector<Summary> summaries;
+	long long fileSize, blockSize, stripeSize;
+	double compressRatio, tolerance = 5.0, latencyTolerance = 10.0;
+	string ioTypeParam, engineParam, syncParam, targetModeParam, queueModeParam, regionsParam, jobFileName, journalFileName, traceFileName, heatmapName, bindAddress, agentDirectory, baselineFileName, saveBaselineFileName;
+	vector<string> fileNames, jobParams, agentAddresses;
+	ClusterController::TestResultList clusterResults;
+	bool clusterFailed = false, baselineFailed = false, dropCaches = false;
+	unsigned int repeatRuns = 1;
+	Baseline baseline, current;
+	size_t testIndex = 0;
+	JobFile jobFile;
+
+	optSeconds = app.add_option("-s,--seconds", seconds, "Duration of test in seconds (optional)");
+	optRamp = app.add_option("--ramp", rampSeconds, "Seconds of I/O executed before the test and not included in the results");
+	optSteadyState = app.add_option("--steady_state", steadyState, "Stop the test when IOPS measured every given seconds reach steady state, -s is the maximum duration");
+	optSteadyWindow = app.add_option("--steady_window", steadyWindow, "Number of rounds checked for steady state (default 5)");
+	optSteadyRange = app.add_option("--steady_range", steadyRange, "Maximum percentage of range between the rounds IOPS in steady state (default 20)");
+	optSteadySlope = app.add_option("--steady_slope", steadySlope, "Maximum percentage of slope of the rounds IOPS in steady state (default 10)");
+	optPrecondition = app.add_option("--precondition", preconditionPasses, "Number of sequential writes of the whole file or device before the test");
+	optPreconditionSeconds = app.add_option("--precondition_seconds", preconditionSeconds, "Maximum seconds of random writes after the sequential ones, ended early by steady state if enabled");
+	optIOType = app.add_option("-i,--io_type", ioTypeParam, "I/O test type (r -> read, w -> write, rw -> read/write, a -> log append with random readers)");
+	optReadPercentage = app.add_option("-p,--read_percentage", readPercentage, "Percentage of read blocks for read/write test");
+	optDiscardPercentage = app.add_option("--discard_percentage", discardPercentage, "Percentage of discarded (trim) blocks for write and read/write tests");
+	optCompressRatio = app.add_option("--compress_ratio", compressRatio, "Compression ratio of the written data (e.g. 2 -> data compressible to half size)");
+	optDedupePercentage = app.add_option("--dedupe_percentage", dedupePercentage, "Percentage of written blocks duplicating other written blocks");
+	optRandom = app.add_flag("-r,--random", "Random read/write");
+	optThreadNumber = app.add_option("-t,--thread", threadNumber, "Number of thread to use for the test");
+	optTaskNumber = app.add_option("-o,--task", taskNumber, "Number of I/O operation per thread");
+	optUnalignedOffsets = app.add_flag("-u,--unaligned", "Different starting offsets for each thread");
+	optFileName = app.add_option("-n,--file_name", fileNames, "Name of the file to use for test, several files or devices can be given to test them together");
+	optFileSize = app.add_option("-z,--file_size", fileSize, "Size of the file to use for test (in Mb), on block devices the whole device is used if missing");
+	optBlockSize = app.add_option("-b,--block_size", blockSize, "Size of the block to read/write (in Kb)");
+	optUseExistingFile = app.add_flag("-e,--use_existing", "If already exist a test file use it instead of create a new one");
+	optVerify = app.add_flag("--verify", "Write a header with offset and generation in every block and check it on read");
+	optJournal = app.add_option("--journal", journalFileName, "File where the generations of the acknowledged writes are saved during a verify test");
+	optCheckJournal = app.add_flag("--check_journal", "Check that every acknowledged write saved in the journal is present in the files (e.g. after a power loss)");
+	optTrace = app.add_option("--trace", traceFileName, "Binary file recording every I/O operation of the test (see DiskBenchmarkTrace)");
+	optHeatmap = app.add_option("--heatmap", heatmapName, "Name of the CSV and SVG files with the latency heatmap over time of every job (without extension)");
+	optHeatmapInterval = app.add_option("--heatmap_interval", heatmapInterval, "Milliseconds of every column of the latency heatmap (default 1000)");
+	optEngine = app.add_option("-g,--engine", engineParam, "I/O engine (system -> operating system async I/O, null -> no I/O, measure benchmark overhead, net -> requests sent to DiskBenchmarkServer, file names are host:port)");
+	optNetDepth = app.add_option("--net_depth", netDepth, "Maximum requests in flight on every connection of the net engine (default 16)");
+	optSync = app.add_option("--sync", syncParam, "Sync written data during the test (fsync, fdatasync)");
+	optSyncWrites = app.add_option("--sync_writes", syncWrites, "Number of completed writes between two sync");
+	optSyncMs = app.add_option("--sync_ms", syncMs, "Milliseconds between two sync");
+	optDataSync = app.add_flag("--dsync", "Open the test file for synchronous data writes (O_DSYNC)");
+	optGroupCommit = app.add_option("--group_commit", groupCommit, "Number of records committed together by the log append test");
+	optRate = app.add_option("--rate", rate, "Maximum I/O operations per second of the test");
+	optAllowDeviceWrite = app.add_flag("--allow_device_write", "Allow write tests on block devices, the content of the device will be destroyed");
+	optProcesses = app.add_flag("--processes", "Run every thread of the test in its own worker process (Linux only)");
+	optTargetMode = app.add_option("--target_mode", targetModeParam, "Distribution of blocks between several files (rr -> round robin, stripe -> stripes of stripe_size, thread -> one file per thread)");
+	optQueueMode = app.add_option("--queue", queueModeParam, "Distribution of blocks between threads (thread -> every thread walks all blocks, shared -> threads take the next blocks from a shared queue, partition -> every thread walks its own part of the blocks, region -> every thread works on its own region of the file)");
+	optRegions = app.add_option("--regions", regionsParam, "Offset and size of the region of every thread separated by ';' (in Mb, e.g. 0:512;512:512), equal parts of the file if missing");
+	optStripeSize = app.add_option("--stripe_size", stripeSize, "Size of the stripe written on each file before moving to the next one (in Kb)");
+	optJobs = app.add_option("--job", jobParams, "Concurrent job as comma separated key=value list, keys are the long option names and missing keys use the options values");
+	optJobFile = app.add_option("-j,--job_file", jobFileName, "INI file describing the tests to execute, options given on command line are used as default values");
+	optAgent = app.add_option("--agent", agentPort, "Run as agent executing the tests sent by a controller on the given TCP port");
+	optBind = app.add_option("--bind", bindAddress, "Address the agent listens on (default 127.0.0.1, 0.0.0.0 for all the interfaces)");
+	optAgentAllowFiles = app.add_flag("--agent_allow_files", "Let the controller enable device writes, journal and trace files and use files outside the agent directory");
+	optAgentDir = app.add_option("--agent_dir", agentDirectory, "Directory of the agent test files, the file names sent by the controller are relative to it (default current directory)");
+	optController = app.add_option("--controller", agentAddresses, "Run the tests on the agents listed (host:port) at the same time and merge their results");
+	optRepeat = app.add_option("--repeat", repeatRuns, "Number of times all the tests are executed, the results of the runs are summarized with mean and confidence interval");
+	optDropCaches = app.add_flag("--drop_caches", "Drop the operating system page cache before every test (Linux only, needs root)");
+	optBaseline = app.add_option("--baseline", baselineFileName, "JSON file with the baseline results, the test fails if throughput or latency are worse than the baseline");
+	optSaveBaseline = app.add_option("--save_baseline", saveBaselineFileName, "Add the results of the test as a new sample of the JSON baseline file (created if missing)");
+	optTolerance = app.add_option("--tolerance", tolerance, "Maximum percentage of IOPS and MB/s under the baseline (default 5)");
+	optLatencyTolerance = app.add_option("--latency_tolerance", latencyTolerance, "Maximum percentage of latency percentiles over the baseline (default 10)");
+	optShowLog = app.add_flag("-l,--log", "Show log messages");
+	optJobs->excludes(optJobFile);
+	optBind->needs(optAgent);
+	optAgentAllowFiles->needs(optAgent);
+	optAgentDir->needs(optAgent);
+	optCheckJournal->needs(optJournal);
+	optTolerance->needs(optBaseline);
+	optLatencyTolerance->needs(optBaseline);
+	CLI11_PARSE(app, argc, argv);
+
+	if(optIOType->count() > 0 && JobFile::parseIOType(ioTypeParam, defaultJob.ioType) == false)
+	{
+		cerr << "Invalid I/O type test param (use -h for help)" << endl;
+		return 1;
+	}
+	if(optEngine->count() > 0 && JobFile::parseEngine(engineParam, defaultTest.engine) == false)
+	{
+		cerr << "Invalid I/O engine param (use -h for help)" << endl;
+		return 1;
+	}
+	if(optTargetMode->count() > 0 && JobFile::parseTargetMode(targetModeParam, defaultJob.targetMode) == false)
+	{
+		cerr << "Invalid target mode param (use -h for help)" << endl;
+		return 1;
+	}
+	if(optQueueMode->count() > 0 && JobFile::parseQueueMode(queueModeParam, defaultJob.queueMode) == false)
+	{
+		cerr << "Invalid queue mode param (use -h for help)" << endl;
+		return 1;
+	}
+	if(optRegions->count() > 0 && JobFile::parseRegions(regionsParam, defaultJob.regions) == false)
+	{
+		cerr << "Invalid regions param (use -h for help)" << endl;
+		return 1;
+	}
+	if(optHeatmap->count() > 0) diskBenchmark.setHeatmapInterval((optHeatmapInterval->count() > 0 && heatmapInterval > 0) ? heatmapInterval : 1000);
+	if(optShowLog->count() > 0) diskBenchmark.setLogMsgFunction([](const string& logMsg) { cout << logMsg << endl; });
+	diskBenchmark.setProgressFunction([](const string &phase, double percentage)
+	{
+		cout << "\r" << phase << " " << fixed << setprecision(1) << percentage << "%" << ((percentage < 100.0) ? "" : "\n") << flush;
+	});
+	if(optThreadNumber->count() > 0) defaultJob.threadNumber = threadNumber;
+	if(optTaskNumber->count() > 0) defaultJob.taskNumber = taskNumber;
+	if(optSeconds->count() > 0 && seconds > 0)
+	{
+		defaultTest.secondsDuration = seconds;
+	}
+	if(optRamp->count() > 0 && rampSeconds > 0)
+	{
+		defaultTest.rampSeconds = rampSeconds;
+	}
+	if(optSteadyState->count() > 0 && steadyState > 0)
+	{
+		defaultTest.steadyStateSeconds = steadyState;
+	}
+	if(optSteadyWindow->count() > 0)
+	{
+		if(steadyWindow < 2)
+		{
+			cerr << "Steady state window must be at least two rounds" << endl;
+			return 1;
+		}
+		defaultTest.steadyStateWindow = steadyWindow;
+	}
+	if(optPrecondition->count() > 0 && preconditionPasses > 0) defaultTest.preconditionPasses = preconditionPasses;
+	if(optPreconditionSeconds->count() > 0 && preconditionSeconds > 0) defaultTest.preconditionSeconds = preconditionSeconds;
+	if(optSteadyRange->count() > 0 && steadyRange >= 0) defaultTest.steadyStateRange = steadyRange;
+	if(optSteadySlope->count() > 0 && steadySlope >= 0) defaultTest.steadyStateSlope = steadySlope;
+	if(optReadPercentage->count() > 0)
+	{
+		if(readPercentage < 0 || readPercentage > 100)
+		{
+			cerr << "Incorrect read percentage value" << endl;
+			return 1;
+		}
+		defaultJob.readPercentage = static_cast<unsigned char>(readPercentage);
+	}
+	if(optDiscardPercentage->count() > 0)
+	{
+		if(discardPercentage < 0 || discardPercentage > 100)
+		{
+			cerr << "Incorrect discard percentage value" << endl;
+			return 1;
+		}
+		defaultJob.discardPercentage = static_cast<unsigned char>(discardPercentage);
+	}
+	if(optCompressRatio->count() > 0)
+	{
+		if(compressRatio < 1.0)
+		{
+			cerr << "Incorrect compression ratio value" << endl;
+			return 1;
+		}
+		defaultJob.compressionRatio = compressRatio;
+	}
+	if(optDedupePercentage->count() > 0)
+	{
+		if(dedupePercentage < 0 || dedupePercentage > 100)
+		{
+			cerr << "Incorrect dedupe percentage value" << endl;
+			return 1;
+		}
+		defaultJob.dedupePercentage = static_cast<unsigned char>(dedupePercentage);
+	}
+	if(optSync->count() > 0)
+	{
+		if(JobFile::parseSyncType(syncParam, defaultJob.syncType) == false)
+		{
+			cerr << "Invalid sync type param (use -h for help)" << endl;
+			return 1;
+		}
+		if((optSyncWrites->count() == 0 || syncWrites <= 0) && (optSyncMs->count() == 0 || syncMs <= 0))
+		{
+			cerr << "Sync require a writes or milliseconds interval" << endl;
+			return 1;
+		}
+		if(optSyncWrites->count() > 0 && syncWrites > 0) defaultJob.syncWritesInterval = syncWrites;
+		if(optSyncMs->count() > 0 && syncMs > 0) defaultJob.syncMsInterval = syncMs;
+	}
+	if(optGroupCommit->count() > 0)
+	{
+		if(groupCommit <= 0)
+		{
+			cerr << "Incorrect group commit value" << endl;
+			return 1;
+		}
+		defaultJob.groupCommit = groupCommit;
+	}
+	if(optRate->count() > 0 && rate > 0) defaultJob.rateLimit = rate;
+	if(optFileSize->count() > 0 && fileSize > 0) defaultJob.fileSize = (fileSize * 1024 * 1024);
+	if(optBlockSize->count() > 0 && blockSize > 0) defaultJob.blockSize = (blockSize * 1024);
+	if(optStripeSize->count() > 0 && stripeSize > 0) defaultJob.stripeSize = (stripeSize * 1024);
+	if(optFileName->count() > 0) defaultJob.fileNames = fileNames;
+	defaultJob.randomAccess = (optRandom->count() > 0) ? true : false;
+	defaultJob.unalignedOffsets = (optUnalignedOffsets->count() > 0) ? true : false;
+	defaultTest.dataSync = (optDataSync->count() > 0) ? true : false;
+	defaultTest.useExistingFile = (optUseExistingFile->count() > 0) ? true : false;
+	defaultTest.verify = (optVerify->count() > 0) ? true : false;
+	if(optJournal->count() > 0) defaultTest.journalFileName = journalFileName;
+	if(optTrace->count() > 0) defaultTest.traceFileName = traceFileName;
+	defaultTest.allowDeviceWrite = (optAllowDeviceWrite->count() > 0) ? true : false;
+	defaultTest.workerProcesses = (optProcesses->count() > 0) ? true : false;
+	if(optNetDepth->count() > 0 && netDepth > 0) defaultTest.networkDepth = netDepth;
+
+	if(optAgent->count() > 0)
+	{
+		ClusterAgent clusterAgent;
+
+		if(agentPort <= 0 || agentPort > 65535)
+		{
+			cerr << "Invalid agent port (use -h for help)" << endl;
+			return 1;
+		}
+		if(optBind->count() > 0) clusterAgent.setBindAddress(bindAddress);
+		clusterAgent.setAllowFiles(optAgentAllowFiles->count() > 0);
+		if(optAgentDir->count() > 0) clusterAgent.setDirectory(agentDirectory);
+		if(optShowLog->count() > 0) clusterAgent.setLogMsgFunction([](const string& logMsg) { cout << logMsg << endl; });
+		return clusterAgent.run(static_cast<unsigned short>(agentPort)) ? 0 : 1;
+	}
+
+	if(optCheckJournal->count() > 0)
+	{
+		DiskBenchmark::JobInfoList jobInfoList;
+		unsigned long long totalVerifyErrors = 0;
+
+		cout << "Check journal..." << endl << endl;
+		JobFile::apply(defaultTest, diskBenchmark);
+		jobInfoList = diskBenchmark.checkJournal(defaultJob.taskNumber);
+		for(const auto &jobInfo : jobInfoList)
+		{
+			cout << "[" << jobInfo.name << "]" << endl;
+			totalVerifyErrors += printJobInfo(jobInfo).totalVerifyErrors;
+			cout << endl;
+		}
+		return (jobInfoList.empty() || totalVerifyErrors > 0) ? 1 : 0;
+	}
+
+	if(optJobFile->count() > 0)
+	{
+		if(jobFile.load(jobFileName, defaultTest, defaultJob) == false)
+		{
+			return 1;
+		}
+		tests = jobFile.getTests();
+	}
+	else
+	{
+		tests.push_back(defaultTest);
+	}
+
+	if(optJobFile->count() == 0 && optJobs->count() == 0)
+	{
+		if(optIOType->count() == 0)
+		{
+			cerr << "Invalid or missing param (use -h for help)" << endl;
+			return 1;
+		}
+		tests.front().jobs.push_back(defaultJob);
+		if(tests.front().jobs.back().name.empty()) tests.front().jobs.back().name = "Job 1";
+	}
+	for(const auto &jobParam : jobParams)
+	{
+		auto &jobs = tests.front().jobs;
+		auto job = defaultJob;
+		auto ioTypeDefined = (optIOType->count() > 0);
+		stringstream paramStream(jobParam);
+		string param;
+
+		job.name = "Job " + to_string(jobs.size() + 1);
+		while(getline(paramStream, param, ','))
+		{
+			const auto separator = param.find('=');
+
+			if(separator == string::npos || JobFile::setJobParam(job, param.substr(0, separator), param.substr(separator + 1)) == false)
+			{
+				cerr << "Invalid job param '" << param << "' (use -h for help)" << endl;
+				return 1;
+			}
+			if(param.substr(0, separator) == "io_type") ioTypeDefined = true;
+		}
+		if(ioTypeDefined == false)
+		{
+			cerr << "Missing I/O type for job '" << job.name << "'" << endl;
+			return 1;
+		}
+		jobs.push_back(job);
+	}
+	for(const auto &test : tests)
+	{
+		for(const auto &job : test.jobs)
+		{
+			if(job.fileNames.empty() || job.blockSize == 0)
+			{
+				cerr << "Invalid or missing param (use -h for help)" << endl;
+				return 1;
+			}
+		}
+	}
+
+	if(optRepeat->count() > 0 && repeatRuns == 0)
+	{
+		cerr << "Invalid repeat param (use -h for help)" << endl;
+		return 1;
+	}
+	if((optTolerance->count() > 0 && tolerance < 0.0) || (optLatencyTolerance->count() > 0 && latencyTolerance < 0.0))
+	{
+		cerr << "Invalid tolerance param (use -h for help)" << endl;
+		return 1;
+	}
+	dropCaches = (optDropCaches->count() > 0) ? true : false;
+	if(optBaseline->count() > 0 && baseline.load(baselineFileName) == false)
+	{
+		return 1;
+	}
+
+	// Every run executes all the tests, the cluster agents get a new connection for each run
+	for(unsigned int run = 1; run <= repeatRuns && interrupted == 0; run++)
+	{
+		clusterResults.clear();
+		testIndex = 0;
+		if(optController->count() > 0)
+		{
+			ClusterController clusterController;
+
+			cout << "Connect to " << agentAddresses.size() << " agents..." << endl;
+			if(clusterController.connect(agentAddresses) == false)
+			{
+				return 1;
+			}
+			cout << "Start benchmark on agents..." << endl << endl;
+			clusterResults = clusterController.run(tests, (optHeatmap->count() > 0) ? ((optHeatmapInterval->count() > 0 && heatmapInterval > 0) ? heatmapInterval : 1000) : 0);
+			if(clusterResults.size() != tests.size())
+			{
+				return 1;
+			}
+		}
+
+		if(clusterResults.empty()) cout << "Start benchmark..." << endl << endl;
+		if(repeatRuns > 1) cout << "--- Run " << run << "/" << repeatRuns << " ---" << endl << endl;
+		interruptedBenchmark = &diskBenchmark;
+		signal(SIGINT, interruptHandler);
+		for(const auto &test : tests)
+		{
+			DiskBenchmark::JobInfoList jobInfoList;
+
+			if(interrupted != 0) break;
+			if(tests.size() > 1) cout << "=== " << test.name << " ===" << endl << endl;
+			if(clusterResults.empty())
+			{
+				if(dropCaches && DiskBenchmark::dropCaches() == false)
+				{
+					return 1;
+				}
+				JobFile::apply(test, diskBenchmark);
+				jobInfoList = diskBenchmark.executeJobs(test.jobs);
+			}
+			else
+			{
+				// Every agent gets a short line, the jobs below merge the threads of all the agents
+				for(const auto &agentResult : clusterResults[testIndex].agents)
+				{
+					cout << "Agent " << agentResult.agent << ":";
+					if(agentResult.completed == false)
+					{
+						cout << " failed" << endl;
+						clusterFailed = true;
+						continue;
+					}
+					for(const auto &agentJobInfo : agentResult.jobInfoList)
+					{
+						const auto agentSummary = DiskBenchmark::summarizeJob(agentJobInfo);
+
+						cout << " [" << agentJobInfo.name << "] " << agentSummary.iops << " IOPS, read " << fixed << setprecision(1) << agentSummary.readMBPerSec
+							 << " MB/s, write " << agentSummary.writeMBPerSec << " MB/s";
+					}
+					cout << endl;
+				}
+				cout << endl;
+				jobInfoList = clusterResults[testIndex].jobInfoList;
+			}
+			testIndex++;
+			if(interrupted != 0) cout << "Test interrupted, partial results" << endl << endl;
+			for(const auto &jobInfo : jobInfoList)
+			{
+				if(jobInfoList.size() > 1) cout << "[" << jobInfo.name << "]" << endl;
+				summaries.push_back({string(), run, printJobInfo(jobInfo)});
+				if(jobInfo.steadyState.rounds > 0)
+				{
+					cout << "Steady state " << (jobInfo.steadyState.reached ? "reached" : "not reached") << " after " << jobInfo.steadyState.rounds << " rounds"
+						 << ", avg IOPS " << fixed << setprecision(0) << jobInfo.steadyState.averageIOPS
+						 << ", range " << setprecision(1) << jobInfo.steadyState.rangePercentage << "%"
+						 << ", slope " << jobInfo.steadyState.slopePercentage << "%" << endl;
+				}
+				summaries.back().name = (tests.size() > 1) ? (test.name + "/" + jobInfo.name) : jobInfo.name;
+				if(optHeatmap->count() > 0)
+				{
+					LatencyHeatmap heatmap;
+					auto fileName = heatmapName;
+
+					for(const auto &threadInfo : jobInfo.threadInfoList)
+					{
+						if(heatmap.empty()) heatmap = LatencyHeatmap(threadInfo.latencyHeatmap.interval());
+						heatmap.merge(threadInfo.latencyHeatmap);
+					}
+					if(tests.size() > 1 || jobInfoList.size() > 1)
+					{
+						fileName += "_" + summaries.back().name;
+						replace_if(fileName.begin() + heatmapName.size(), fileName.end(), [](char character) { return (isalnum(static_cast<unsigned char>(character)) == 0); }, '_');
+					}
+					if(repeatRuns > 1) fileName += "_run" + to_string(run);
+					if(heatmap.writeCsv(fileName + ".csv") && heatmap.writeSvg(fileName + ".svg", summaries.back().name))
+					{
+						cout << "Latency heatmap saved in " << fileName << ".csv and " << fileName << ".svg" << endl;
+					}
+				}
+				cout << endl;
+			}
+		}
+
+		signal(SIGINT, SIG_DFL);
+		interruptedBenchmark = nullptr;
+	}
+
+	if(summaries.size() > 1)
+	{
+		const auto us = [](double nsValue) { return (nsValue / 1000.0); };
+
+		cout << "Summary" << endl;
+		for(const auto &summary : summaries)
+		{
+			cout << "  " << summary.name << ((repeatRuns > 1) ? (" run " + to_string(summary.run)) : string()) << ": " << summary.job.msDuration << " ms"
+				 << ", read " << fixed << setprecision(1) << summary.job.readMBPerSec << " MB/s"
+				 << ", write " << summary.job.writeMBPerSec << " MB/s"
+				 << ", " << summary.job.iops << " IOPS"
+				 << ", read p99 " << us(summary.job.readLatency.percentile(99.0)) << " us"
+				 << ", write p99 " << us(summary.job.writeLatency.percentile(99.0)) << " us" << endl;
+		}
+	}
+
+	if(interrupted != 0) return 130;
+
+	for(const auto &summary : summaries) current.addSample(summary.name, summary.job);
+	if(repeatRuns > 1)
+	{
+		cout << endl << "Runs " << repeatRuns << " (mean, stddev, min, max, 95% confidence interval)" << endl;
+		for(const auto &job : current.getJobs())
+		{
+			cout << "  " << job.name << endl;
+			for(const auto &metric : job.metrics)
+			{
+				const auto mean = Baseline::mean(metric.samples);
+				const auto interval = Baseline::confidenceInterval(metric.samples, 0.95);
+
+				cout << "    " << metric.name << ": mean " << fixed << setprecision(1) << mean << ", stddev " << sqrt(Baseline::variance(metric.samples))
+					 << ", min " << *min_element(metric.samples.begin(), metric.samples.end()) << ", max " << *max_element(metric.samples.begin(), metric.samples.end())
+					 << ", CI " << (mean - interval) << " - " << (mean + interval) << endl;
+			}
+		}
+	}
+
+	if(optBaseline->count() > 0 || optSaveBaseline->count() > 0)
+	{
+		if(optBaseline->count() > 0)
+		{
+			const auto comparisons = Baseline::compare(baseline, current, tolerance, latencyTolerance);
+			unsigned int regressions = 0;
+
+			// Jobs are matched by name, p is the probability of a worsening this large by chance (missing with a single sample)
+			cout << endl << "Baseline " << baselineFileName << endl;
+			for(const auto &comparison : comparisons)
+			{
+				cout << "  " << comparison.jobName << " " << comparison.metricName << ": " << fixed << setprecision(1) << comparison.baselineMean << " -> " << comparison.currentMean
+					 << " (" << showpos << comparison.changePercentage << noshowpos << "%";
+				if(comparison.pValue >= 0.0) cout << ", p " << setprecision(3) << comparison.pValue;
+				cout << ") " << (comparison.regression ? "REGRESSION" : "ok") << endl;
+				if(comparison.regression) regressions++;
+			}
+			if(comparisons.empty()) cout << "  No job of the test found in the baseline" << endl;
+			baselineFailed = (comparisons.empty() || regressions > 0);
+			cout << "Baseline verdict: " << (baselineFailed ? "FAIL" : "PASS");
+			if(regressions > 0) cout << ", " << regressions << " regressions";
+			cout << endl;
+		}
+		if(optSaveBaseline->count() > 0)
+		{
+			Baseline saved;
+
+			if(filesystem::exists(saveBaselineFileName) && saved.load(saveBaselineFileName) == false)
+			{
+				return 1;
+			}
+			saved.addSamples(current);
+			if(saved.save(saveBaselineFileName) == false)
+			{
+				return 1;
+			}
+			cout << "Results added to baseline " << saveBaselineFileName << endl;
+		}
+	}
+
+	if(clusterFailed) return 1;
+
+	return baselineFailed ? 2 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <cstring>
+#include "NetFile.h"
+
+using namespace std;
+
+NetFile::NetFile(exception_ptr &exception) : SystemFile(exception),
+											 m_port(DefaultPort),
+											 m_fileSize(0),
+											 m_depth(0),
+											 m_dataSync(false)
+{
+}
+
+NetFile::~NetFile()
+{
+}
+
+void NetFile::setDepth(unsigned int depth)
+{
+	m_depth = depth;
+}
+
+bool NetFile::initialize(const string &fileName, bool, bool dataSync, unsigned long long fileSize, unsigned char *block, unsigned long long blockSize, bool useExisting)
+{
+	Connection connection;
+
+	// File name is the address of the block server, the size of its file is fixed by the server like a block device
+	if(parseAddress(fileName, m_host, m_port) == false)
+	{
+		cerr << "Invalid block server address " << fileName << endl;
+		return false;
+	}
+	if(blockSize > MaxBlockSize)
+	{
+		cerr << "Block size over the maximum of the block server (" << (MaxBlockSize / (1024 * 1024)) << "MB)" << endl;
+		return false;
+	}
+	if(connection.socket.connect(m_host, m_port) == false)
+	{
+		return false;
+	}
+	if(openConnection(&connection, false, m_fileSize) == false)
+	{
+		cerr << "No answer from block server " << fileName << endl;
+		return false;
+	}
+	if(m_fileSize < blockSize)
+	{
+		cerr << "Block server " << fileName << " file is smaller than a block" << endl;
+		return false;
+	}
+	m_dataSync = dataSync;
+
+	// Like a new local file the blocks of the test are filled with the pattern, unless the existing content is used
+	if(useExisting == false)
+	{
+		const auto blockNumber = (((fileSize > 0) ? min(fileSize, m_fileSize) : m_fileSize) / blockSize);
+
+		try
+		{
+			for(unsigned long long i = 0; i < blockNumber; i++)
+			{
+				submitRequest(&connection, Operation::Write, i * blockSize, blockSize, block, nullptr);
+				while(!connection.pendingRequests.empty()) waitCompletion(&connection);
+			}
+			while(connection.inFlight > 0 || !connection.completedBlocks.empty()) waitCompletion(&connection);
+		}
+		catch(runtime_error&)
+		{
+			cerr << "Unable to write inside the file of block server " << fileName << endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void NetFile::close(bool)
+{
+}
+
+NetFile::FileHandle NetFile::openFile(unsigned int taskNumber)
+{
+	auto connection = new Connection();
+	FileHandle file{};
+	unsigned long long fileSize;
+
+	// Every thread has its own connection where its requests are pipelined, the server opens the file with the sync flags of the test
+	if(connection->socket.connect(m_host, m_port) == false || openConnection(connection, m_dataSync, fileSize) == false)
+	{
+		delete connection;
+		throw runtime_error("Unable to connect to the block server");
+	}
+	connection->readBuffers.reserve(taskNumber);
+	file.engineData = connection;
+
+	return file;
+}
+
+void NetFile::closeFile(FileHandle file)
+{
+	delete reinterpret_cast<Connection*>(file.engineData);
+}
+
+void NetFile::writeBlock(FileHandle file, unsigned long long offset, unsigned char *data, unsigned long long size, BlockHandle *block)
+{
+	submitRequest(reinterpret_cast<Connection*>(file.engineData), Operation::Write, offset, size, data, block);
+}
+
+void NetFile::readBlock(FileHandle file, unsigned long long offset, unsigned char *data, unsigned long long size, BlockHandle *block)
+{
+	submitRequest(reinterpret_cast<Connection*>(file.engineData), Operation::Read, offset, size, data, block);
+}
+
+bool NetFile::syncFile(FileHandle file, bool dataOnly, BlockHandle *block)
+{
+	submitRequest(reinterpret_cast<Connection*>(file.engineData), dataOnly ? Operation::DataSync : Operation::Sync, 0, 0, nullptr, block);
+	return true;
+}
+
+bool NetFile::discardBlock(FileHandle, unsigned long long, unsigned long long, BlockHandle *)
+{
+	// Block server doesn't support discard, the operation is completed immediately
+	return false;
+}
+
+NetFile::BlockHandle* NetFile::getCompletedBlock(FileHandle file)
+{
+	auto connection = reinterpret_cast<Connection*>(file.engineData);
+
+	if(connection->completedBlocks.empty() && (connection->inFlight == 0 || connection->socket.waitReadable(0) == false))
+	{
+		return nullptr;
+	}
+
+	return waitCompletion(connection);
+}
+
+NetFile::BlockHandle* NetFile::waitCompletion(Connection *connection)
+{
+	BlockHandle *block;
+
+	// Completions received while a request was being sent are returned first
+	if(connection->completedBlocks.empty())
+	{
+		block = receiveCompletion(connection);
+	}
+	else
+	{
+		block = connection->completedBlocks.front();
+		connection->completedBlocks.pop_front();
+	}
+	sendPendingRequests(connection);
+
+	return block;
+}
+
+NetFile::BlockHandle* NetFile::receiveCompletion(Connection *connection)
+{
+	Response response;
+
+	if(connection->socket.receive(&response, sizeof(response)) == false || response.magic != Magic)
+	{
+		throw runtime_error("Connection to the block server lost");
+	}
+	if(response.status != 0)
+	{
+		throw runtime_error("Block server request failed");
+	}
+
+	// Data of a read follows its response, the size is in the value field
+	const auto readBuffer = connection->readBuffers.find(response.tag);
+
+	if(readBuffer != connection->readBuffers.end())
+	{
+		if(connection->socket.receive(readBuffer->second, response.value) == false)
+		{
+			throw runtime_error("Connection to the block server lost");
+		}
+		connection->readBuffers.erase(readBuffer);
+	}
+	connection->inFlight--;
+
+	return reinterpret_cast<BlockHandle*>(response.tag);
+}
+
+void NetFile::sendPendingRequests(Connection *connection)
+{
+	while(!connection->pendingRequests.empty() && canSend(connection))
+	{
+		const auto pendingRequest = connection->pendingRequests.front();
+
+		connection->pendingRequests.pop_front();
+		sendRequest(connection, pendingRequest.request, pendingRequest.data);
+	}
+}
+
+bool NetFile::openConnection(Connection *connection, bool dataSync, unsigned long long &fileSize)
+{
+	Request request;
+	Response response;
+
+	// Open is answered with the size of the server file before any other request is sent on the connection
+	request.magic = Magic;
+	request.operation = static_cast<unsigned int>(Operation::Open);
+	request.offset = (dataSync ? OpenDataSync : 0);
+	request.size = 0;
+	request.tag = 0;
+	if(connection->socket.send(&request, sizeof(request)) == false || connection->socket.receive(&response, sizeof(response)) == false
+	|| response.magic != Magic || response.status != 0)
+	{
+		return false;
+	}
+	fileSize = response.value;
+
+	return true;
+}
+
+unsigned long long NetFile::getFileSize()
+{
+	return m_fileSize;
+}
+
+unsigned int NetFile::getBlockAlignment()
+{
+	return 512;
+}
+
+bool NetFile::isBlockDevice()
+{
+	return false;
+}
+
+bool NetFile::parseAddress(const string &address, string &host, unsigned short &port)
+{
+	const auto separator = address.rfind(':');
+	unsigned long value = DefaultPort;
+
+	try
+	{
+		if(separator != string::npos) value = stoul(address.substr(separator + 1));
+	}
+	catch(logic_error&)
+	{
+		return false;
+	}
+	if(value == 0 || value > 65535)
+	{
+		return false;
+	}
+	host = address.substr(0, separator);
+	port = static_cast<unsigned short>(value);
+
+	return !host.empty();
+}
+
+void NetFile::submitRequest(Connection *connection, Operation operation, unsigned long long offset, unsigned long long size, unsigned char *data, BlockHandle *block)
+{
+	PendingRequest pendingRequest;
+
+	pendingRequest.request.magic = Magic;
+	pendingRequest.request.operation = static_cast<unsigned int>(operation);
+	pendingRequest.request.offset = offset;
+	pendingRequest.request.size = size;
+	pendingRequest.request.tag = reinterpret_cast<unsigned long long>(block);
+	pendingRequest.data = data;
+	if(operation == Operation::Read) connection->readBuffers[pendingRequest.request.tag] = data;
+
+	// Requests beyond the depth wait for the completion of the previous ones, in their order
+	if(connection->pendingRequests.empty() && canSend(connection))
+		sendRequest(connection, pendingRequest.request, data);
+	else
+		connection->pendingRequests.push_back(pendingRequest);
+}
+
+void NetFile::sendRequest(Connection *connection, const Request &request, const unsigned char *data)
+{
+	const auto dataSize = (request.operation == static_cast<unsigned int>(Operation::Write)) ? request.size : 0;
+
+	size_t sentSize = 0;
+
+	// Header and written data leave together. The server answers in order and blocks when its responses are not read,
+	// so the responses arriving while the socket buffer is full are received meanwhile and their completions queued
+	connection->sendBuffer.resize(sizeof(request) + dataSize);
+	memcpy(connection->sendBuffer.data(), &request, sizeof(request));
+	if(dataSize > 0) memcpy(&connection->sendBuffer[sizeof(request)], data, dataSize);
+	while(sentSize < connection->sendBuffer.size())
+	{
+		size_t size = 0;
+		bool readable = false, writable = false;
+
+		if(connection->socket.sendAvailable(&connection->sendBuffer[sentSize], connection->sendBuffer.size() - sentSize, size) == false)
+		{
+			throw runtime_error("Connection to the block server lost");
+		}
+		sentSize += size;
+		if(sentSize == connection->sendBuffer.size())
+		{
+			break;
+		}
+		if(connection->socket.wait(readable, writable) == false)
+		{
+			throw runtime_error("Connection to the block server lost");
+		}
+		if(readable && connection->inFlight > 0) connection->completedBlocks.push_back(receiveCompletion(connection));
+	}
+	connection->inFlight++;
+}
+
+bool NetFile::canSend(const Connection *connection) const
+{
+	return (connection->inFlight < ((m_depth > 0) ? m_depth : DefaultDepth));
+}
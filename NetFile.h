@@ -0,0 +1,95 @@
+#pragma once
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+#include "SystemFile.h"
+#include "Socket.h"
+
+class NetFile : public SystemFile
+{
+	static constexpr unsigned int DefaultDepth = 16;
+
+public:
+	NetFile(std::exception_ptr &exception);
+	~NetFile();
+
+	static constexpr unsigned int Magic = 0x4E424244;
+	static constexpr unsigned short DefaultPort = 7900;
+	static constexpr unsigned long long MaxBlockSize = (64 * 1024 * 1024);
+
+	// Open request carries the flags of the connection in its offset
+	static constexpr unsigned long long OpenDataSync = 1;
+
+	enum class Operation
+	{
+		Open = 0,
+		Read,
+		Write,
+		Sync,
+		DataSync
+	};
+	struct Request
+	{
+		unsigned int magic;
+		unsigned int operation;
+		unsigned long long offset;
+		unsigned long long size;
+		unsigned long long tag;
+	};
+	struct Response
+	{
+		unsigned int magic;
+		unsigned int status;
+		unsigned long long value;
+		unsigned long long tag;
+	};
+
+	void setDepth(unsigned int depth);
+
+	bool initialize(const std::string &fileName, bool directAccess, bool dataSync, unsigned long long fileSize, unsigned char *block, unsigned long long blockSize, bool useExisting = false) override;
+	void close(bool removeFile = true) override;
+
+	FileHandle openFile(unsigned int taskNumber) override;
+	void closeFile(FileHandle file) override;
+	void writeBlock(FileHandle file, unsigned long long offset, unsigned char *data, unsigned long long size, BlockHandle *block) override;
+	void readBlock(FileHandle file, unsigned long long offset, unsigned char *data, unsigned long long size, BlockHandle *block) override;
+	bool syncFile(FileHandle file, bool dataOnly, BlockHandle *block) override;
+	bool discardBlock(FileHandle file, unsigned long long offset, unsigned long long size, BlockHandle *block) override;
+	BlockHandle* getCompletedBlock(FileHandle file) override;
+	unsigned long long getFileSize() override;
+	unsigned int getBlockAlignment() override;
+	bool isBlockDevice() override;
+
+	static bool parseAddress(const std::string &address, std::string &host, unsigned short &port);
+
+private:
+	struct PendingRequest
+	{
+		Request request;
+		unsigned char *data;
+	};
+	struct Connection
+	{
+		Socket socket;
+		unsigned int inFlight = 0;
+		std::deque<PendingRequest> pendingRequests;
+		std::deque<BlockHandle*> completedBlocks;
+		std::unordered_map<unsigned long long, unsigned char*> readBuffers;
+		std::vector<unsigned char> sendBuffer;
+	};
+
+	std::string m_host;
+	unsigned short m_port;
+	unsigned long long m_fileSize;
+	unsigned int m_depth;
+	bool m_dataSync;
+
+	void submitRequest(Connection *connection, Operation operation, unsigned long long offset, unsigned long long size, unsigned char *data, BlockHandle *block);
+	void sendRequest(Connection *connection, const Request &request, const unsigned char *data);
+	BlockHandle* waitCompletion(Connection *connection);
+	BlockHandle* receiveCompletion(Connection *connection);
+	void sendPendingRequests(Connection *connection);
+	bool openConnection(Connection *connection, bool dataSync, unsigned long long &fileSize);
+	bool canSend(const Connection *connection) const;
+};
@@ -0,0 +1,86 @@
+#include "NullFile.h"
+
+using namespace std;
+
+NullFile::NullFile(exception_ptr &exception) : SystemFile(exception),
+											   m_fileSize(0)
+{
+}
+
+NullFile::~NullFile()
+{
+}
+
+bool NullFile::initialize(const string &, bool, bool, unsigned long long fileSize, unsigned char *, unsigned long long, bool)
+{
+	m_fileSize = fileSize;
+	return true;
+}
+
+void NullFile::close(bool)
+{
+}
+
+NullFile::FileHandle NullFile::openFile(unsigned int taskNumber)
+{
+	auto completedBlocks = new CompletedBlockList();
+	FileHandle file{};
+
+	// Every block complete immediately at submit time so at most taskNumber blocks can be waiting
+	completedBlocks->reserve(taskNumber);
+	file.engineData = completedBlocks;
+
+	return file;
+}
+
+void NullFile::closeFile(FileHandle file)
+{
+	delete reinterpret_cast<CompletedBlockList*>(file.engineData);
+}
+
+void NullFile::writeBlock(FileHandle file, unsigned long long, unsigned char *, unsigned long long, BlockHandle *block)
+{
+	reinterpret_cast<CompletedBlockList*>(file.engineData)->push_back(block);
+}
+
+void NullFile::readBlock(FileHandle file, unsigned long long, unsigned char *, unsigned long long, BlockHandle *block)
+{
+	reinterpret_cast<CompletedBlockList*>(file.engineData)->push_back(block);
+}
+
+bool NullFile::syncFile(FileHandle file, bool, BlockHandle *block)
+{
+	reinterpret_cast<CompletedBlockList*>(file.engineData)->push_back(block);
+	return true;
+}
+
+bool NullFile::discardBlock(FileHandle file, unsigned long long, unsigned long long, BlockHandle *block)
+{
+	reinterpret_cast<CompletedBlockList*>(file.engineData)->push_back(block);
+	return true;
+}
+
+NullFile::BlockHandle* NullFile::getCompletedBlock(FileHandle file)
+{
+	auto completedBlocks = reinterpret_cast<CompletedBlockList*>(file.engineData);
+	BlockHandle *block;
+
+	if(completedBlocks->empty())
+	{
+		return nullptr;
+	}
+	block = completedBlocks->back();
+	completedBlocks->pop_back();
+
+	return block;
+}
+
+unsigned long long NullFile::getFileSize()
+{
+	return m_fileSize;
+}
+
+unsigned int NullFile::getBlockAlignment()
+{
+	return getMemoryPageSize();
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+#include "SystemFile.h"
+
+class NullFile : public SystemFile
+{
+public:
+	NullFile(std::exception_ptr &exception);
+	~NullFile();
+
+	bool initialize(const std::string &fileName, bool directAccess, bool dataSync, unsigned long long fileSize, unsigned char *block, unsigned long long blockSize, bool useExisting = false) override;
+	void close(bool removeFile = true) override;
+
+	FileHandle openFile(unsigned int taskNumber) override;
+	void closeFile(FileHandle file) override;
+	void writeBlock(FileHandle file, unsigned long long offset, unsigned char *data, unsigned long long size, BlockHandle *block) override;
+	void readBlock(FileHandle file, unsigned long long offset, unsigned char *data, unsigned long long size, BlockHandle *block) override;
+	bool syncFile(FileHandle file, bool dataOnly, BlockHandle *block) override;
+	bool discardBlock(FileHandle file, unsigned long long offset, unsigned long long size, BlockHandle *block) override;
+	BlockHandle* getCompletedBlock(FileHandle file) override;
+	unsigned long long getFileSize() override;
+	unsigned int getBlockAlignment() override;
+
+private:
+	using CompletedBlockList = std::vector<BlockHandle*>;
+
+	unsigned long long m_fileSize;
+};
\ No newline at end of file
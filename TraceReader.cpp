@@ -0,0 +1,110 @@
+#include <fstream>
+#include <iomanip>
+#include "EventTrace.h"
+#include "LatencyHeatmap.h"
+#include "LatencyHistogram.h"
+#include "CLI11/CLI.hpp"
+
+using namespace std;
+
+int main(int argc, char **argv)
+{
+	const char *operationNames[] = {"read", "write", "discard", "sync"};
+	CLI::Option *optCsv, *optHeatmap, *optSvg, *optInterval, *optOperation;
+	CLI::App app("DiskBenchmarkTrace");
+	string traceFileName, csvFileName, heatmapFileName, svgFileName, operationParam;
+	LatencyHistogram latencies[4];
+	unsigned long long eventsNumber = 0, nsLastComplete = 0;
+	int msInterval, operationFilter = -1;
+	EventTrace::Header header;
+	EventTrace::Event event;
+	ifstream traceFile;
+	ofstream csvFile;
+
+	app.add_option("trace_file", traceFileName, "Binary trace file written by DiskBenchmark --trace")->required();
+	optCsv = app.add_option("-c,--csv", csvFileName, "Write every event of the trace as a line of a CSV file");
+	optHeatmap = app.add_option("-m,--heatmap", heatmapFileName, "Write the number of operations per interval and latency range as a CSV file");
+	optSvg = app.add_option("--svg", svgFileName, "Draw the heatmap in a SVG image");
+	optInterval = app.add_option("--interval", msInterval, "Interval of the heatmap rows in milliseconds (default 1000)");
+	optOperation = app.add_option("--operation", operationParam, "Operations included in the heatmap (read, write, discard, sync, all operations if missing)");
+	CLI11_PARSE(app, argc, argv);
+
+	if(optInterval->count() == 0 || msInterval <= 0) msInterval = 1000;
+	if(optOperation->count() > 0)
+	{
+		for(int i = 0; i < 4; i++)
+		{
+			if(operationParam == operationNames[i]) operationFilter = i;
+		}
+		if(operationFilter < 0)
+		{
+			cerr << "Invalid operation param (use -h for help)" << endl;
+			return 1;
+		}
+	}
+
+	LatencyHeatmap heatmap(static_cast<unsigned long long>(msInterval) * 1000000);
+
+	traceFile.open(traceFileName, ios::binary);
+	if(!traceFile.is_open())
+	{
+		cerr << "Unable to open trace file " << traceFileName << endl;
+		return 1;
+	}
+	if(!traceFile.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != EventTrace::Magic || header.version != EventTrace::Version || header.eventSize != sizeof(EventTrace::Event))
+	{
+		cerr << "Invalid trace file " << traceFileName << endl;
+		return 1;
+	}
+	if(optCsv->count() > 0)
+	{
+		csvFile.open(csvFileName);
+		if(!csvFile.is_open())
+		{
+			cerr << "Unable to create CSV file " << csvFileName << endl;
+			return 1;
+		}
+		csvFile << "submit_us,complete_us,latency_us,thread,target,operation,offset,size,result" << endl;
+		csvFile << fixed << setprecision(3);
+	}
+
+	while(traceFile.read(reinterpret_cast<char*>(&event), sizeof(event)))
+	{
+		const auto nsLatency = (event.nsComplete - event.nsSubmit);
+
+		if(event.operation >= 4)
+		{
+			cerr << "Invalid event " << eventsNumber << " in trace file " << traceFileName << endl;
+			return 1;
+		}
+
+		eventsNumber++;
+		latencies[event.operation].add(nsLatency);
+		if(event.nsComplete > nsLastComplete) nsLastComplete = event.nsComplete;
+		if(operationFilter < 0 || operationFilter == event.operation) heatmap.add(event.nsSubmit, nsLatency);
+		if(csvFile.is_open())
+		{
+			csvFile << (event.nsSubmit / 1000.0) << "," << (event.nsComplete / 1000.0) << "," << (nsLatency / 1000.0) << ","
+					<< event.thread << "," << static_cast<unsigned int>(event.target) << "," << operationNames[event.operation] << ","
+					<< event.offset << "," << event.size << "," << ((event.result == 0) ? "ok" : "verify_error") << endl;
+		}
+	}
+
+	cout << "Events " << eventsNumber << ", duration (ms) " << (nsLastComplete / 1000000) << endl;
+	for(int i = 0; i < 4; i++)
+	{
+		if(latencies[i].count() == 0) continue;
+		cout << "  " << operationNames[i] << ": " << latencies[i].count() << " ops, latency (us) avg " << fixed << setprecision(1) << (latencies[i].mean() / 1000.0)
+			 << ", p99 " << (latencies[i].percentile(99.0) / 1000.0) << ", max " << (latencies[i].max() / 1000.0) << endl;
+	}
+	if(optHeatmap->count() > 0 && heatmap.writeCsv(heatmapFileName) == false)
+	{
+		return 1;
+	}
+	if(optSvg->count() > 0 && heatmap.writeSvg(svgFileName, traceFileName + ((operationFilter < 0) ? "" : (string(" ") + operationNames[operationFilter]))) == false)
+	{
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <vector>
+#include "BlockFile.h"
+
+using namespace std;
+
+BlockFile::BlockFile() : m_hFile(INVALID_HANDLE_VALUE)
+{
+}
+
+BlockFile::~BlockFile()
+{
+	close();
+}
+
+bool BlockFile::open(const string &fileName, bool dataSync)
+{
+	vector<TCHAR> name;
+
+	close();
+	name.resize(MultiByteToWideChar(CP_ACP, 0, fileName.c_str(), -1, NULL, 0));
+	MultiByteToWideChar(CP_ACP, 0, fileName.c_str(), -1, name.data(), name.size());
+	m_hFile = CreateFile(name.data(),
+						 GENERIC_READ | GENERIC_WRITE,
+						 FILE_SHARE_READ | FILE_SHARE_WRITE,
+						 NULL,
+						 OPEN_EXISTING,
+						 FILE_ATTRIBUTE_NORMAL | (dataSync ? FILE_FLAG_WRITE_THROUGH : 0),
+						 NULL);
+
+	return (m_hFile != INVALID_HANDLE_VALUE);
+}
+
+void BlockFile::close()
+{
+	if(m_hFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_hFile);
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+}
+
+bool BlockFile::isOpen() const
+{
+	return (m_hFile != INVALID_HANDLE_VALUE);
+}
+
+bool BlockFile::read(unsigned long long offset, unsigned char *data, unsigned long long size)
+{
+	// Offset of a synchronous handle is given by the overlapped structure, a transfer is at most 4GB
+	while(size > 0)
+	{
+		OVERLAPPED overlapped = {};
+		DWORD bytesRead = 0;
+
+		overlapped.Offset = static_cast<DWORD>(offset);
+		overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+		if(ReadFile(m_hFile, data, static_cast<DWORD>((std::min)(size, 0x80000000ULL)), &bytesRead, &overlapped) == FALSE || bytesRead == 0)
+		{
+			return false;
+		}
+		offset += bytesRead;
+		data += bytesRead;
+		size -= bytesRead;
+	}
+
+	return true;
+}
+
+bool BlockFile::write(unsigned long long offset, const unsigned char *data, unsigned long long size)
+{
+	while(size > 0)
+	{
+		OVERLAPPED overlapped = {};
+		DWORD bytesWritten = 0;
+
+		overlapped.Offset = static_cast<DWORD>(offset);
+		overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+		if(WriteFile(m_hFile, data, static_cast<DWORD>((std::min)(size, 0x80000000ULL)), &bytesWritten, &overlapped) == FALSE || bytesWritten == 0)
+		{
+			return false;
+		}
+		offset += bytesWritten;
+		data += bytesWritten;
+		size -= bytesWritten;
+	}
+
+	return true;
+}
+
+bool BlockFile::sync(bool)
+{
+	// Windows has no data only flush, metadata are flushed too
+	return (FlushFileBuffers(m_hFile) != FALSE);
+}
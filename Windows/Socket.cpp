@@ -0,0 +1,269 @@
+#include <WS2tcpip.h>
+#include "Socket.h"
+
+using namespace std;
+
+Socket::Socket() : m_socket(INVALID_SOCKET)
+{
+	startup();
+}
+
+Socket::Socket(Socket &&other) : m_socket(other.m_socket)
+{
+	other.m_socket = INVALID_SOCKET;
+}
+
+Socket::~Socket()
+{
+	close();
+}
+
+Socket& Socket::operator=(Socket &&other)
+{
+	if(this != &other)
+	{
+		close();
+		m_socket = other.m_socket;
+		other.m_socket = INVALID_SOCKET;
+	}
+	return *this;
+}
+
+bool Socket::startup()
+{
+	// Winsock is initialized once for the whole process
+	static const bool initialized = []()
+	{
+		WSADATA data;
+		return (WSAStartup(MAKEWORD(2, 2), &data) == 0);
+	}();
+
+	return initialized;
+}
+
+bool Socket::listen(const string &address, unsigned short port)
+{
+	const char reuse = 1;
+	addrinfo hints, *addresses;
+
+	close();
+	ZeroMemory(&hints, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	hints.ai_flags = AI_PASSIVE;
+	if(getaddrinfo(address.c_str(), to_string(port).c_str(), &hints, &addresses) != 0)
+	{
+		cerr << "Unable to resolve address " << address << endl;
+		return false;
+	}
+	for(auto bindAddress = addresses; bindAddress != nullptr && m_socket == INVALID_SOCKET; bindAddress = bindAddress->ai_next)
+	{
+		m_socket = socket(bindAddress->ai_family, bindAddress->ai_socktype, bindAddress->ai_protocol);
+		if(m_socket == INVALID_SOCKET) continue;
+		setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+		if(bind(m_socket, bindAddress->ai_addr, static_cast<int>(bindAddress->ai_addrlen)) == SOCKET_ERROR || ::listen(m_socket, SOMAXCONN) == SOCKET_ERROR) close();
+	}
+	freeaddrinfo(addresses);
+	if(m_socket == INVALID_SOCKET)
+	{
+		cerr << "Unable to listen on " << address << ":" << port << endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool Socket::accept(Socket &client)
+{
+	const char noDelay = 1;
+	SOCKET clientSocket;
+
+	clientSocket = ::accept(m_socket, nullptr, nullptr);
+	if(clientSocket == INVALID_SOCKET)
+	{
+		return false;
+	}
+	setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+	client.close();
+	client.m_socket = clientSocket;
+
+	return true;
+}
+
+bool Socket::connect(const string &host, unsigned short port)
+{
+	const char noDelay = 1;
+	addrinfo hints, *addresses;
+
+	close();
+	ZeroMemory(&hints, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	if(getaddrinfo(host.c_str(), to_string(port).c_str(), &hints, &addresses) != 0)
+	{
+		cerr << "Unable to resolve host " << host << endl;
+		return false;
+	}
+	for(auto address = addresses; address != nullptr && m_socket == INVALID_SOCKET; address = address->ai_next)
+	{
+		m_socket = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+		if(m_socket != INVALID_SOCKET && ::connect(m_socket, address->ai_addr, static_cast<int>(address->ai_addrlen)) == SOCKET_ERROR) close();
+	}
+	freeaddrinfo(addresses);
+	if(m_socket == INVALID_SOCKET)
+	{
+		cerr << "Unable to connect to " << host << ":" << port << endl;
+		return false;
+	}
+	setsockopt(m_socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+	return true;
+}
+
+void Socket::close()
+{
+	if(m_socket != INVALID_SOCKET)
+	{
+		closesocket(m_socket);
+		m_socket = INVALID_SOCKET;
+	}
+}
+
+bool Socket::isOpen() const
+{
+	return (m_socket != INVALID_SOCKET);
+}
+
+bool Socket::waitReadable(unsigned int msTimeout)
+{
+	WSAPOLLFD pollData;
+
+	pollData.fd = m_socket;
+	pollData.events = POLLRDNORM;
+	pollData.revents = 0;
+
+	return (WSAPoll(&pollData, 1, static_cast<INT>(msTimeout)) > 0);
+}
+
+bool Socket::wait(bool &readable, bool &writable)
+{
+	WSAPOLLFD pollData;
+
+	pollData.fd = m_socket;
+	pollData.events = (POLLRDNORM | POLLWRNORM);
+	pollData.revents = 0;
+	if(WSAPoll(&pollData, 1, -1) <= 0 || (pollData.revents & (POLLERR | POLLNVAL)) != 0)
+	{
+		return false;
+	}
+	readable = ((pollData.revents & (POLLRDNORM | POLLHUP)) != 0);
+	writable = ((pollData.revents & POLLWRNORM) != 0);
+
+	return true;
+}
+
+string Socket::getPeerName() const
+{
+	sockaddr_storage address;
+	int addressSize = sizeof(address);
+	char host[NI_MAXHOST], port[NI_MAXSERV];
+
+	if(getpeername(m_socket, reinterpret_cast<sockaddr*>(&address), &addressSize) == SOCKET_ERROR
+	|| getnameinfo(reinterpret_cast<sockaddr*>(&address), addressSize, host, sizeof(host), port, sizeof(port), NI_NUMERICHOST | NI_NUMERICSERV) != 0)
+	{
+		return string();
+	}
+
+	return string(host) + ":" + port;
+}
+
+bool Socket::send(const void *data, size_t size)
+{
+	auto buffer = static_cast<const char*>(data);
+
+	while(size > 0)
+	{
+		const auto sent = ::send(m_socket, buffer, static_cast<int>(size), 0);
+
+		if(sent <= 0) return false;
+		buffer += sent;
+		size -= sent;
+	}
+
+	return true;
+}
+
+bool Socket::sendAvailable(const void *data, size_t size, size_t &sentSize)
+{
+	u_long nonBlocking = 1;
+	int sent, error;
+
+	// Socket is non-blocking only for this send, so it sends only what fits the socket buffer without waiting
+	ioctlsocket(m_socket, FIONBIO, &nonBlocking);
+	sent = ::send(m_socket, static_cast<const char*>(data), static_cast<int>(size), 0);
+	error = WSAGetLastError();
+	nonBlocking = 0;
+	ioctlsocket(m_socket, FIONBIO, &nonBlocking);
+	if(sent == SOCKET_ERROR && error == WSAEWOULDBLOCK)
+	{
+		sentSize = 0;
+		return true;
+	}
+	if(sent <= 0) return false;
+	sentSize = static_cast<size_t>(sent);
+
+	return true;
+}
+
+bool Socket::receive(void *data, size_t size)
+{
+	auto buffer = static_cast<char*>(data);
+
+	while(size > 0)
+	{
+		const auto received = ::recv(m_socket, buffer, static_cast<int>(size), 0);
+
+		if(received <= 0) return false;
+		buffer += received;
+		size -= received;
+	}
+
+	return true;
+}
+
+bool Socket::sendMessage(const string &message)
+{
+	const u_long size = htonl(static_cast<u_long>(message.size()));
+
+	if(message.size() > MaxMessageSize)
+	{
+		cerr << "Message of " << message.size() << " bytes over the limit" << endl;
+		return false;
+	}
+
+	// Every message is preceded by its size in network byte order
+	return (send(&size, sizeof(size)) && send(message.data(), message.size()));
+}
+
+bool Socket::receiveMessage(string &message)
+{
+	u_long size;
+
+	if(receive(&size, sizeof(size)) == false)
+	{
+		return false;
+	}
+
+	// Size comes from the peer, a message over the limit closes the connection instead of allocating it
+	if(ntohl(size) > MaxMessageSize)
+	{
+		cerr << "Message of " << ntohl(size) << " bytes from " << getPeerName() << " over the limit" << endl;
+		close();
+		return false;
+	}
+	message.resize(ntohl(size));
+
+	return receive(&message[0], message.size());
+}
@@ -1,200 +1,333 @@
-#include <vector>
-#include "SystemFile.h"
-
-using namespace std;
-
-SystemFile::SystemFile(exception_ptr &exception) : m_hFile(INVALID_HANDLE_VALUE),
-												   m_logMsgFunction([](const string &logMsg) {})
-{
-}
-
-SystemFile::~SystemFile()
-{
-}
-
-void SystemFile::setLogMsgFunction(const LogMsgFunction &logMsgFunction)
-{
-	m_logMsgFunction = logMsgFunction;
-}
-
-bool SystemFile::initialize(const string &fileName, bool directAccess, unsigned long long fileSize, unsigned char *block, unsigned long long blockSize, bool useExisting)
-{
-	const auto blockNumber = (fileSize / blockSize);
-	WIN32_FILE_ATTRIBUTE_DATA fileInfo;
-	vector<TCHAR> name;
-
-	close(!useExisting);
-
-	name.resize(MultiByteToWideChar(CP_ACP, 0, fileName.c_str(), -1, NULL, 0));
-	MultiByteToWideChar(CP_ACP, 0, fileName.c_str(), -1, name.data(), name.size());
-	
-	if(useExisting == false
-	|| GetFileAttributesEx(name.data(), GetFileExInfoStandard, &fileInfo) == FALSE
-	|| ((static_cast<unsigned long long>(fileInfo.nFileSizeHigh) << 32) | static_cast<unsigned long long>(fileInfo.nFileSizeLow)) != fileSize)
-	{
-		HANDLE hFile = CreateFile(name.data(),
-								  GENERIC_WRITE,
-								  NULL,
-								  NULL,
-								  CREATE_ALWAYS,
-								  FILE_ATTRIBUTE_NORMAL,
-								  NULL);
-		if(hFile == INVALID_HANDLE_VALUE)
-		{
-			cerr << "Unable to create file " << fileName << endl;
-			return false;
-		}
-		for(unsigned long long i = 0; i < blockNumber; i++)
-		{
-			DWORD bytesWritten = 0;
-
-			if(WriteFile(hFile, block, static_cast<DWORD>(blockSize), &bytesWritten, NULL) == FALSE || bytesWritten != blockSize)
-			{
-				cerr << "Unable to write inside file " << fileName << endl;
-				return false;
-			}
-		}
-		FlushFileBuffers(hFile);
-		CloseHandle(hFile);
-		m_logMsgFunction("New test file '" + fileName + "' created");
-	}
-	
-	m_fileFlags = FILE_FLAG_OVERLAPPED;
-	if(directAccess) m_fileFlags |= (FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH);
-	m_hFile = CreateFile(name.data(),
-						 GENERIC_READ | GENERIC_WRITE,
-						 FILE_SHARE_READ | FILE_SHARE_WRITE,
-						 NULL,
-						 OPEN_EXISTING,
-						 m_fileFlags,
-						 NULL);
-	if(m_hFile == INVALID_HANDLE_VALUE)
-	{
-		DeleteFile(name.data());
-		return false;
-	}
-
-	return true;
-}
-
-void SystemFile::close(bool removeFile)
-{
-	if(m_hFile != INVALID_HANDLE_VALUE)
-	{
-		TCHAR filePath[MAX_PATH];
-
-		GetFinalPathNameByHandle(m_hFile, filePath, MAX_PATH, VOLUME_NAME_DOS);
-		CloseHandle(m_hFile);
-		if(removeFile) DeleteFile(filePath);
-
-		m_hFile = INVALID_HANDLE_VALUE;
-	}
-}
-
-SystemFile::FileHandle SystemFile::openFile(unsigned int taskNumber)
-{
-	TCHAR filePath[MAX_PATH];
-	FileHandle file;
-
-	if(GetFinalPathNameByHandle(m_hFile, filePath, MAX_PATH, VOLUME_NAME_DOS) == 0)
-	{
-		throw runtime_error("GetFinalPathNameByHandle() return error " + GetLastError());
-	}
-	file.handle = CreateFile(filePath,
-							 GENERIC_READ | GENERIC_WRITE,
-							 FILE_SHARE_READ | FILE_SHARE_WRITE,
-							 NULL,
-							 OPEN_EXISTING,
-							 m_fileFlags,
-							 NULL);
-	if(file.handle == INVALID_HANDLE_VALUE)
-	{
-		throw runtime_error("CreateFile() return error " + GetLastError());
-	}
-	file.ioCompletionPort = CreateIoCompletionPort(file.handle, NULL, 0, 0);
-	if(file.ioCompletionPort == INVALID_HANDLE_VALUE)
-	{
-		throw runtime_error("CreateIoCompletionPort() return error " + GetLastError());
-	}
-
-	return file;
-}
-
-void SystemFile::closeFile(FileHandle file)
-{
-	CloseHandle(file.ioCompletionPort);
-	CloseHandle(file.handle);
-}
-
-void SystemFile::writeBlock(FileHandle file, unsigned long long offset, unsigned char *data, unsigned long long size, BlockHandle *block)
-{
-	ZeroMemory(block, sizeof(BlockHandle));
-	block->Offset = (offset & 0xFFFFFFFF);
-	block->OffsetHigh = (offset >> 32);
-	if(WriteFile(file.handle, data, static_cast<DWORD>(size), NULL, block) == FALSE)
-	{
-		const auto error = GetLastError();
-
-		if(error != ERROR_IO_PENDING)
-		{
-			throw runtime_error("WriteFile() return error " + error);
-		}
-	}
-}
-
-void SystemFile::readBlock(FileHandle file, unsigned long long offset, unsigned char *data, unsigned long long size, BlockHandle *block)
-{
-	ZeroMemory(block, sizeof(BlockHandle));
-	block->Offset = (offset & 0xFFFFFFFF);
-	block->OffsetHigh = (offset >> 32);
-	if(ReadFile(file.handle, data, static_cast<DWORD>(size), NULL, block) == FALSE)
-	{
-		const auto error = GetLastError();
-
-		if(error != ERROR_IO_PENDING)
-		{
-			throw runtime_error("ReadFile() return error " + error);
-		}
-	}
-}
-
-SystemFile::BlockHandle* SystemFile::getCompletedBlock(FileHandle file)
-{
-	ULONG_PTR completionKey = 0;
-	DWORD bytesTransferred;
-	LPOVERLAPPED pOvl;
-	BOOL result;
-
-	result = GetQueuedCompletionStatus(file.ioCompletionPort,
-									   &bytesTransferred,
-									   &completionKey,
-									   &pOvl,
-									   0);
-	if(result == TRUE)
-	{
-		return pOvl;
-	}
-	else if(pOvl != NULL)
-	{
-		throw runtime_error("GetQueuedCompletionStatus() block operation failed");
-	}
-
-	return nullptr;
-}
-
-unsigned char* SystemFile::allocateAlignedMemory(unsigned long long size)
-{
-	return reinterpret_cast<unsigned char*>(VirtualAlloc(NULL, size, MEM_COMMIT, PAGE_READWRITE));
-}
-
-void SystemFile::freeAlignedMemory(unsigned char *ptr)
-{
-	VirtualFree(ptr, 0, MEM_RELEASE);
-}
-
-unsigned int SystemFile::getMemoryPageSize()
-{
-	SYSTEM_INFO systemInfo;
-	GetSystemInfo(&systemInfo);
-	return systemInfo.dwPageSize;
-}
+#include <vector>
+#include "SystemFile.h"
+#include <winioctl.h>
+
+using namespace std;
+
+SystemFile::SystemFile(exception_ptr &exception) : m_hFile(INVALID_HANDLE_VALUE),
+												   m_fileSize(0),
+												   m_blockAlignment(0),
+												   m_blockDevice(false),
+												   m_sparseFile(false),
+												   m_logMsgFunction([](const string &logMsg) {})
+{
+}
+
+SystemFile::~SystemFile()
+{
+}
+
+void SystemFile::setLogMsgFunction(const LogMsgFunction &logMsgFunction)
+{
+	m_logMsgFunction = logMsgFunction;
+}
+
+bool SystemFile::initialize(const string &fileName, bool directAccess, bool dataSync, unsigned long long fileSize, unsigned char *block, unsigned long long blockSize, bool useExisting)
+{
+	WIN32_FILE_ATTRIBUTE_DATA fileInfo;
+	vector<TCHAR> name;
+
+	close(!useExisting);
+
+	name.resize(MultiByteToWideChar(CP_ACP, 0, fileName.c_str(), -1, NULL, 0));
+	MultiByteToWideChar(CP_ACP, 0, fileName.c_str(), -1, name.data(), name.size());
+	
+	// Block devices (\\.\PhysicalDriveN or \\.\X:) are used as they are, without any creation or prefill
+	m_blockDevice = (fileName.rfind("\\\\.\\", 0) == 0);
+	m_sparseFile = false;
+	if(m_blockDevice == false
+	&& (useExisting == false
+	|| GetFileAttributesEx(name.data(), GetFileExInfoStandard, &fileInfo) == FALSE
+	|| ((static_cast<unsigned long long>(fileInfo.nFileSizeHigh) << 32) | static_cast<unsigned long long>(fileInfo.nFileSizeLow)) != fileSize))
+	{
+		const auto blockNumber = (fileSize / blockSize);
+		HANDLE hFile;
+
+		if(blockNumber == 0)
+		{
+			cerr << "Invalid size for file " << fileName << endl;
+			return false;
+		}
+		hFile = CreateFile(name.data(),
+						   GENERIC_WRITE,
+						   NULL,
+						   NULL,
+						   CREATE_ALWAYS,
+						   FILE_ATTRIBUTE_NORMAL,
+						   NULL);
+		if(hFile == INVALID_HANDLE_VALUE)
+		{
+			cerr << "Unable to create file " << fileName << endl;
+			return false;
+		}
+		for(unsigned long long i = 0; i < blockNumber; i++)
+		{
+			DWORD bytesWritten = 0;
+
+			if(WriteFile(hFile, block, static_cast<DWORD>(blockSize), &bytesWritten, NULL) == FALSE || bytesWritten != blockSize)
+			{
+				cerr << "Unable to write inside file " << fileName << endl;
+				return false;
+			}
+		}
+		FlushFileBuffers(hFile);
+		CloseHandle(hFile);
+		m_logMsgFunction("New test file '" + fileName + "' created");
+	}
+	
+	m_fileFlags = FILE_FLAG_OVERLAPPED;
+	if(directAccess) m_fileFlags |= (FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH);
+	if(dataSync) m_fileFlags |= FILE_FLAG_WRITE_THROUGH;
+	m_hFile = CreateFile(name.data(),
+						 GENERIC_READ | GENERIC_WRITE,
+						 FILE_SHARE_READ | FILE_SHARE_WRITE,
+						 NULL,
+						 OPEN_EXISTING,
+						 m_fileFlags,
+						 NULL);
+	if(m_hFile == INVALID_HANDLE_VALUE)
+	{
+		if(m_blockDevice == false) DeleteFile(name.data());
+		return false;
+	}
+
+	m_fileName = name;
+	m_fileSize = fileSize;
+	m_blockAlignment = getMemoryPageSize();
+	if(m_blockDevice)
+	{
+		STORAGE_PROPERTY_QUERY query = {StorageAccessAlignmentProperty, PropertyStandardQuery};
+		STORAGE_ACCESS_ALIGNMENT_DESCRIPTOR alignment = {};
+		GET_LENGTH_INFORMATION lengthInfo = {};
+		DWORD bytesReturned = 0;
+
+		if(DeviceIoControl(m_hFile, IOCTL_DISK_GET_LENGTH_INFO, NULL, 0, &lengthInfo, sizeof(lengthInfo), &bytesReturned, NULL) == FALSE
+		|| DeviceIoControl(m_hFile, IOCTL_STORAGE_QUERY_PROPERTY, &query, sizeof(query), &alignment, sizeof(alignment), &bytesReturned, NULL) == FALSE)
+		{
+			cerr << "Unable to get geometry of block device " << fileName << endl;
+			close(false);
+			return false;
+		}
+		if(fileSize == 0 || fileSize > static_cast<unsigned long long>(lengthInfo.Length.QuadPart)) m_fileSize = lengthInfo.Length.QuadPart;
+		m_blockAlignment = alignment.BytesPerLogicalSector;
+		m_logMsgFunction("Block device '" + fileName + "' size " + to_string(lengthInfo.Length.QuadPart) + " bytes, logical block " + to_string(alignment.BytesPerLogicalSector) + " bytes, physical block " + to_string(alignment.BytesPerPhysicalSector) + " bytes");
+	}
+	else
+	{
+		OVERLAPPED overlapped = {};
+		DWORD bytesReturned = 0;
+
+		// Zeroing a range releases its clusters only on sparse files, on the others it writes zeros
+		overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+		m_sparseFile = (DeviceIoControl(m_hFile, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &bytesReturned, &overlapped) != FALSE
+					 || (GetLastError() == ERROR_IO_PENDING && GetOverlappedResult(m_hFile, &overlapped, &bytesReturned, TRUE) != FALSE));
+		CloseHandle(overlapped.hEvent);
+		if(directAccess)
+		{
+			FILE_STORAGE_INFO storageInfo = {};
+
+			if(GetFileInformationByHandleEx(m_hFile, FileStorageInfo, &storageInfo, sizeof(storageInfo)) != FALSE && storageInfo.LogicalBytesPerSector > 0)
+			{
+				m_blockAlignment = storageInfo.LogicalBytesPerSector;
+			}
+		}
+	}
+
+	return true;
+}
+
+void SystemFile::close(bool removeFile)
+{
+	if(m_hFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_hFile);
+		if(removeFile && m_blockDevice == false) DeleteFile(m_fileName.data());
+
+		m_fileName.clear();
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+}
+
+SystemFile::FileHandle SystemFile::openFile(unsigned int taskNumber)
+{
+	FileHandle file;
+
+	file.handle = CreateFile(m_fileName.data(),
+							 GENERIC_READ | GENERIC_WRITE,
+							 FILE_SHARE_READ | FILE_SHARE_WRITE,
+							 NULL,
+							 OPEN_EXISTING,
+							 m_fileFlags,
+							 NULL);
+	if(file.handle == INVALID_HANDLE_VALUE)
+	{
+		throw runtime_error("CreateFile() return error " + GetLastError());
+	}
+	file.ioCompletionPort = CreateIoCompletionPort(file.handle, NULL, 0, 0);
+	if(file.ioCompletionPort == INVALID_HANDLE_VALUE)
+	{
+		throw runtime_error("CreateIoCompletionPort() return error " + GetLastError());
+	}
+
+	return file;
+}
+
+void SystemFile::closeFile(FileHandle file)
+{
+	CloseHandle(file.ioCompletionPort);
+	CloseHandle(file.handle);
+}
+
+void SystemFile::writeBlock(FileHandle file, unsigned long long offset, unsigned char *data, unsigned long long size, BlockHandle *block)
+{
+	ZeroMemory(block, sizeof(BlockHandle));
+	block->Offset = (offset & 0xFFFFFFFF);
+	block->OffsetHigh = (offset >> 32);
+	if(WriteFile(file.handle, data, static_cast<DWORD>(size), NULL, block) == FALSE)
+	{
+		const auto error = GetLastError();
+
+		if(error != ERROR_IO_PENDING)
+		{
+			throw runtime_error("WriteFile() return error " + error);
+		}
+	}
+}
+
+void SystemFile::readBlock(FileHandle file, unsigned long long offset, unsigned char *data, unsigned long long size, BlockHandle *block)
+{
+	ZeroMemory(block, sizeof(BlockHandle));
+	block->Offset = (offset & 0xFFFFFFFF);
+	block->OffsetHigh = (offset >> 32);
+	if(ReadFile(file.handle, data, static_cast<DWORD>(size), NULL, block) == FALSE)
+	{
+		const auto error = GetLastError();
+
+		if(error != ERROR_IO_PENDING)
+		{
+			throw runtime_error("ReadFile() return error " + error);
+		}
+	}
+}
+
+bool SystemFile::syncFile(FileHandle file, bool dataOnly, BlockHandle *block)
+{
+	// Windows doesn't provide an asynchronous flush, sync is executed immediately
+	if(FlushFileBuffers(file.handle) == FALSE)
+	{
+		throw runtime_error("FlushFileBuffers() return error " + to_string(GetLastError()));
+	}
+
+	return false;
+}
+
+bool SystemFile::discardBlock(FileHandle file, unsigned long long offset, unsigned long long size, BlockHandle *block)
+{
+	BOOL result;
+
+	// Input buffers are copied by the system so the request can complete later through the completion port
+	ZeroMemory(block, sizeof(BlockHandle));
+	if(m_blockDevice)
+	{
+		struct
+		{
+			DEVICE_MANAGE_DATA_SET_ATTRIBUTES attributes;
+			DEVICE_DATA_SET_RANGE range;
+		} trim{};
+
+		trim.attributes.Size = sizeof(DEVICE_MANAGE_DATA_SET_ATTRIBUTES);
+		trim.attributes.Action = DeviceDsmAction_Trim;
+		trim.attributes.Flags = DEVICE_DSM_FLAG_TRIM_NOT_FS_ALLOCATED;
+		trim.attributes.DataSetRangesOffset = offsetof(decltype(trim), range);
+		trim.attributes.DataSetRangesLength = sizeof(DEVICE_DATA_SET_RANGE);
+		trim.range.StartingOffset = offset;
+		trim.range.LengthInBytes = size;
+		result = DeviceIoControl(file.handle, IOCTL_STORAGE_MANAGE_DATA_SET_ATTRIBUTES, &trim, sizeof(trim), NULL, 0, NULL, block);
+	}
+	else
+	{
+		FILE_ZERO_DATA_INFORMATION zeroData;
+
+		if(m_sparseFile == false)
+		{
+			throw runtime_error("Discard requires a file system with sparse files support");
+		}
+		zeroData.FileOffset.QuadPart = offset;
+		zeroData.BeyondFinalZero.QuadPart = (offset + size);
+		result = DeviceIoControl(file.handle, FSCTL_SET_ZERO_DATA, &zeroData, sizeof(zeroData), NULL, 0, NULL, block);
+	}
+	if(result == FALSE)
+	{
+		const auto error = GetLastError();
+
+		if(error != ERROR_IO_PENDING)
+		{
+			throw runtime_error("DeviceIoControl() return error " + to_string(error));
+		}
+	}
+
+	return true;
+}
+
+SystemFile::BlockHandle* SystemFile::getCompletedBlock(FileHandle file)
+{
+	ULONG_PTR completionKey = 0;
+	DWORD bytesTransferred;
+	LPOVERLAPPED pOvl;
+	BOOL result;
+
+	result = GetQueuedCompletionStatus(file.ioCompletionPort,
+									   &bytesTransferred,
+									   &completionKey,
+									   &pOvl,
+									   0);
+	if(result == TRUE)
+	{
+		return pOvl;
+	}
+	else if(pOvl != NULL)
+	{
+		throw runtime_error("GetQueuedCompletionStatus() block operation failed");
+	}
+
+	return nullptr;
+}
+
+unsigned char* SystemFile::allocateAlignedMemory(unsigned long long size)
+{
+	return reinterpret_cast<unsigned char*>(VirtualAlloc(NULL, size, MEM_COMMIT, PAGE_READWRITE));
+}
+
+void SystemFile::freeAlignedMemory(unsigned char *ptr)
+{
+	VirtualFree(ptr, 0, MEM_RELEASE);
+}
+
+unsigned int SystemFile::getMemoryPageSize()
+{
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	return systemInfo.dwPageSize;
+}
+
+
+unsigned long long SystemFile::getFileSize()
+{
+	return m_fileSize;
+}
+
+unsigned int SystemFile::getBlockAlignment()
+{
+	return m_blockAlignment;
+}
+
+bool SystemFile::isBlockDevice()
+{
+	return m_blockDevice;
+}
+
+bool SystemFile::dropCaches()
+{
+	cerr << "Drop of the page cache not supported" << endl;
+	return false;
+}
\ No newline at end of file
@@ -1,40 +1,53 @@
-#pragma once
-
-#include <functional>
-#include <iostream>
-#include <Windows.h>
-
-class SystemFile
-{
-public:
-	SystemFile(std::exception_ptr &exception);
-	~SystemFile();
-
-	using LogMsgFunction = std::function<void(const std::string &logMsg)>;
-
-	struct FileHandle
-	{
-		HANDLE handle;
-		HANDLE ioCompletionPort;
-	};
-	using BlockHandle = OVERLAPPED;
-
-	void setLogMsgFunction(const LogMsgFunction &logMsgFunction);
-
-	bool initialize(const std::string &fileName, bool directAccess, unsigned long long fileSize, unsigned char *block, unsigned long long blockSize, bool useExisting = false);
-	void close(bool removeFile = true);
-
-	FileHandle openFile(unsigned int taskNumber);
-	void closeFile(FileHandle file);
-	void writeBlock(FileHandle file, unsigned long long offset, unsigned char *data, unsigned long long size, BlockHandle *block);
-	void readBlock(FileHandle file, unsigned long long offset, unsigned char *data, unsigned long long size, BlockHandle *block);
-	BlockHandle* getCompletedBlock(FileHandle file);
-	unsigned char* allocateAlignedMemory(unsigned long long size);
-	void freeAlignedMemory(unsigned char *ptr);
-	unsigned int getMemoryPageSize();
-
-private:
-	HANDLE m_hFile;
-	DWORD m_fileFlags;
-	LogMsgFunction m_logMsgFunction;
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <iostream>
+#include <Windows.h>
+
+class SystemFile
+{
+public:
+	SystemFile(std::exception_ptr &exception);
+	virtual ~SystemFile();
+
+	using LogMsgFunction = std::function<void(const std::string &logMsg)>;
+
+	struct FileHandle
+	{
+		HANDLE handle;
+		HANDLE ioCompletionPort;
+		void *engineData = nullptr;
+	};
+	using BlockHandle = OVERLAPPED;
+
+	void setLogMsgFunction(const LogMsgFunction &logMsgFunction);
+
+	virtual bool initialize(const std::string &fileName, bool directAccess, bool dataSync, unsigned long long fileSize, unsigned char *block, unsigned long long blockSize, bool useExisting = false);
+	virtual void close(bool removeFile = true);
+
+	virtual FileHandle openFile(unsigned int taskNumber);
+	virtual void closeFile(FileHandle file);
+	virtual void writeBlock(FileHandle file, unsigned long long offset, unsigned char *data, unsigned long long size, BlockHandle *block);
+	virtual void readBlock(FileHandle file, unsigned long long offset, unsigned char *data, unsigned long long size, BlockHandle *block);
+	virtual bool syncFile(FileHandle file, bool dataOnly, BlockHandle *block);
+	virtual bool discardBlock(FileHandle file, unsigned long long offset, unsigned long long size, BlockHandle *block);
+	virtual BlockHandle* getCompletedBlock(FileHandle file);
+	unsigned char* allocateAlignedMemory(unsigned long long size);
+	void freeAlignedMemory(unsigned char *ptr);
+	unsigned int getMemoryPageSize();
+	virtual unsigned long long getFileSize();
+	virtual unsigned int getBlockAlignment();
+	virtual bool isBlockDevice();
+	static bool dropCaches();
+
+private:
+	HANDLE m_hFile;
+	DWORD m_fileFlags;
+	std::vector<TCHAR> m_fileName;
+	unsigned long long m_fileSize;
+	unsigned int m_blockAlignment;
+	bool m_blockDevice;
+	bool m_sparseFile;
+	LogMsgFunction m_logMsgFunction;
 };
\ No newline at end of file
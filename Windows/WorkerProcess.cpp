@@ -0,0 +1,33 @@
+#include "WorkerProcess.h"
+
+using namespace std;
+
+// Windows has no fork, worker processes would need a new process image receiving the whole test
+WorkerProcess::WorkerProcess()
+{
+}
+
+WorkerProcess::~WorkerProcess()
+{
+}
+
+void* WorkerProcess::allocateSharedMemory(size_t size)
+{
+	cerr << "Worker processes are available only on Linux" << endl;
+	return nullptr;
+}
+
+bool WorkerProcess::start(const WorkerFunction &function)
+{
+	return false;
+}
+
+bool WorkerProcess::isRunning()
+{
+	return false;
+}
+
+bool WorkerProcess::exitedNormally() const
+{
+	return false;
+}
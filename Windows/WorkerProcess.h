@@ -0,0 +1,18 @@
+#pragma once
+
+#include <functional>
+#include <iostream>
+
+class WorkerProcess
+{
+public:
+	WorkerProcess();
+	~WorkerProcess();
+
+	using WorkerFunction = std::function<void(void *sharedMemory)>;
+
+	void* allocateSharedMemory(size_t size);
+	bool start(const WorkerFunction &function);
+	bool isRunning();
+	bool exitedNormally() const;
+};